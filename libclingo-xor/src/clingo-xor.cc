@@ -68,20 +68,39 @@ bool check(clingo_propagate_control_t* i, void* data) {
     CLINGOXOR_CATCH;
 }
 
+//! C decide callback for the XOR propagator.
+bool decide(clingo_id_t thread_id, clingo_assignment_t const *assignment, clingo_literal_t fallback, void *data, clingo_literal_t *decision) {
+    CLINGOXOR_TRY {
+        Clingo::Assignment ass(assignment);
+        *decision = static_cast<Propagator*>(data)->decide(thread_id, ass, fallback);
+    }
+    CLINGOXOR_CATCH;
+}
+
 //! High level interface to use the XOR propagator.
 class XORPropagatorFacade {
 public:
-    XORPropagatorFacade(clingo_control_t *control, char const *theory, bool enable_propagate)
-    : prop_{enable_propagate} {
+    XORPropagatorFacade(clingo_control_t *control, char const *theory, Config const &config)
+    : prop_{config} {
         handle_error(clingo_control_add(control, "base", nullptr, 0, theory));
         static clingo_propagator_t prop = {
+            init,
+            propagate,
+            undo,
+            check,
+            decide
+        };
+        // Note: The decide callback is only needed to influence decisions.
+        // Otherwise, registering it would add overhead to every decision.
+        static clingo_propagator_t prop_no_decide = {
             init,
             propagate,
             undo,
             check,
             nullptr
         };
-        handle_error(clingo_control_register_propagator(control, &prop, &prop_, false));
+        auto *reg = config.phase || config.activity ? &prop : &prop_no_decide;
+        handle_error(clingo_control_register_propagator(control, reg, &prop_, false));
     }
 
     //! Add the propagator statistics to clingo's statistics.
@@ -124,6 +143,102 @@ bool parse_bool(const char *value, void *data) {
     return false;
 }
 
+//! Parse a refactorization factor and store it in data.
+//!
+//! The factor must be zero or at least one. Return false if there is a parse
+//! error.
+bool parse_factor(const char *value, void *data) {
+    auto &result = *static_cast<double*>(data);
+    char *end = nullptr;
+    double factor = std::strtod(value, &end);
+    if (end == value || *end != '\0' || !(factor == 0 || factor >= 1)) {
+        return false;
+    }
+    result = factor;
+    return true;
+}
+
+//! Parse the engine and store it in data.
+//!
+//! Return false if there is a parse error.
+bool parse_engine(const char *value, void *data) {
+    auto &result = *static_cast<Engine*>(data);
+    if (iequals(value, "simplex")) {
+        result = Engine::Simplex;
+        return true;
+    }
+    if (iequals(value, "gj")) {
+        result = Engine::GaussJordan;
+        return true;
+    }
+    return false;
+}
+
+//! Parse the clause type and store it in data.
+//!
+//! Return false if there is a parse error.
+bool parse_clause_type(const char *value, void *data) {
+    auto &result = *static_cast<Clingo::ClauseType*>(data);
+    if (iequals(value, "learnt")) {
+        result = Clingo::ClauseType::Learnt;
+        return true;
+    }
+    if (iequals(value, "static")) {
+        result = Clingo::ClauseType::Static;
+        return true;
+    }
+    if (iequals(value, "volatile")) {
+        result = Clingo::ClauseType::Volatile;
+        return true;
+    }
+    if (iequals(value, "volatile-static")) {
+        result = Clingo::ClauseType::VolatileStatic;
+        return true;
+    }
+    return false;
+}
+
+//! Parse a non-negative integer and store it in data.
+//!
+//! Return false if there is a parse error.
+bool parse_size(const char *value, void *data) {
+    auto &result = *static_cast<size_t*>(data);
+    char *end = nullptr;
+    auto size = std::strtoull(value, &end, 10);
+    if (end == value || *end != '\0' || *value == '-') {
+        return false;
+    }
+    result = size;
+    return true;
+}
+
+//! Parse the length up to which constraints are translated and store it in
+//! data.
+//!
+//! Because the translation is exponential, the length must be at most 20.
+//! Return false if there is a parse error.
+bool parse_translate(const char *value, void *data) {
+    size_t translate = 0;
+    if (!parse_size(value, &translate) || translate > 20) {
+        return false;
+    }
+    *static_cast<size_t*>(data) = translate;
+    return true;
+}
+
+//! Parse the length to cut constraints at and store it in data.
+//!
+//! The length must be zero or at least three. Return false if there is a
+//! parse error.
+bool parse_cut(const char *value, void *data) {
+    size_t cut = 0;
+    if (!parse_size(value, &cut) || cut == 1 || cut == 2) {
+        return false;
+    }
+    *static_cast<size_t*>(data) = cut;
+    return true;
+}
+
 //! Set the given error message if the Boolean is false.
 //!
 //! Return false if there is a parse error.
@@ -139,7 +254,7 @@ bool check_parse(char const *key, bool ret) {
 } // namespace
 
 struct clingoxor_theory {
-    bool propagate{true};
+    Config config;
     std::unique_ptr<XORPropagatorFacade> clingoxor{nullptr};
 };
 
@@ -162,7 +277,7 @@ extern "C" bool clingoxor_create(clingoxor_theory_t **theory) {
 
 extern "C" bool clingoxor_register(clingoxor_theory_t *theory, clingo_control_t* control) {
     CLINGOXOR_TRY {
-        theory->clingoxor = std::make_unique<XORPropagatorFacade>(control, THEORY, theory->propagate);
+        theory->clingoxor = std::make_unique<XORPropagatorFacade>(control, THEORY, theory->config);
     }
     CLINGOXOR_CATCH;
 }
@@ -185,8 +300,65 @@ extern "C" bool clingoxor_destroy(clingoxor_theory_t *theory) {
 
 extern "C" bool clingoxor_configure(clingoxor_theory_t *theory, char const *key, char const *value) {
     CLINGOXOR_TRY {
+        if (strcmp(key, "engine") == 0) {
+            return check_parse("engine", parse_engine(value, &theory->config.engine));
+        }
+        if (strcmp(key, "parse-threads") == 0) {
+            return check_parse("parse-threads", parse_size(value, &theory->config.parse_threads));
+        }
         if (strcmp(key, "propagate") == 0) {
-            return check_parse("propagate", parse_bool(value, &theory->propagate));
+            return check_parse("propagate", parse_bool(value, &theory->config.propagate));
+        }
+        if (strcmp(key, "check-only") == 0) {
+            return check_parse("check-only", parse_bool(value, &theory->config.check_only));
+        }
+        if (strcmp(key, "check-interval") == 0) {
+            return check_parse("check-interval", parse_size(value, &theory->config.check_interval));
+        }
+        if (strcmp(key, "activity") == 0) {
+            return check_parse("activity", parse_bool(value, &theory->config.activity));
+        }
+        if (strcmp(key, "phase") == 0) {
+            return check_parse("phase", parse_bool(value, &theory->config.phase));
+        }
+        if (strcmp(key, "propagate-binary") == 0) {
+            return check_parse("propagate-binary", parse_bool(value, &theory->config.propagate_binary));
+        }
+        if (strcmp(key, "shortest-conflict") == 0) {
+            return check_parse("shortest-conflict", parse_bool(value, &theory->config.shortest_conflict));
+        }
+        if (strcmp(key, "equivalences") == 0) {
+            return check_parse("equivalences", parse_bool(value, &theory->config.equivalences));
+        }
+        if (strcmp(key, "eliminate") == 0) {
+            return check_parse("eliminate", parse_bool(value, &theory->config.eliminate));
+        }
+        if (strcmp(key, "dense") == 0) {
+            return check_parse("dense", parse_bool(value, &theory->config.dense));
+        }
+        if (strcmp(key, "watched-length") == 0) {
+            return check_parse("watched-length", parse_size(value, &theory->config.watched_length));
+        }
+        if (strcmp(key, "translate") == 0) {
+            return check_parse("translate", parse_translate(value, &theory->config.translate));
+        }
+        if (strcmp(key, "cut") == 0) {
+            return check_parse("cut", parse_cut(value, &theory->config.cut));
+        }
+        if (strcmp(key, "clause-type") == 0) {
+            return check_parse("clause-type", parse_clause_type(value, &theory->config.clause_type));
+        }
+        if (strcmp(key, "reason-length") == 0) {
+            return check_parse("reason-length", parse_size(value, &theory->config.reason_length));
+        }
+        if (strcmp(key, "pivot-budget") == 0) {
+            return check_parse("pivot-budget", parse_size(value, &theory->config.pivot_budget));
+        }
+        if (strcmp(key, "refactor") == 0) {
+            return check_parse("refactor", parse_factor(value, &theory->config.refactor));
+        }
+        if (strcmp(key, "revert") == 0) {
+            return check_parse("revert", parse_factor(value, &theory->config.revert));
         }
         std::ostringstream msg;
         msg << "invalid configuration key '" << key << "'";
@@ -199,9 +371,84 @@ extern "C" bool clingoxor_configure(clingoxor_theory_t *theory, char const *key,
 extern "C" bool clingoxor_register_options(clingoxor_theory_t *theory, clingo_options_t* options) {
     CLINGOXOR_TRY {
         char const *group = "Clingo.XOR Options";
+        handle_error(clingo_options_add(options, group, "engine",
+            "Select the engine to solve XOR constraints [simplex]\n"
+            "      <arg>: {simplex,gj}\n"
+            "        simplex: simplex-based solver\n"
+            "        gj     : Gauss-Jordan elimination with watched columns\n"
+            "                 (simplex if the matrix exceeds 128 MiB per thread)",
+            parse_engine, &theory->config.engine, false, "<arg>"));
+        handle_error(clingo_options_add(options, group, "parse-threads",
+            "Evaluate theory atoms using <n> threads [0]\n"
+            "      <n>: 0 (one per core) or number of threads",
+            parse_size, &theory->config.parse_threads, false, "<n>"));
         handle_error(clingo_options_add_flag(options, group, "propagate",
             "Enable propagation [yes]",
-            &theory->propagate));
+            &theory->config.propagate));
+        handle_error(clingo_options_add_flag(options, group, "check-only",
+            "Only solve XOR constraints when checking assignments [no]",
+            &theory->config.check_only));
+        handle_error(clingo_options_add(options, group, "check-interval",
+            "With check-only, also check partial assignments every <n> levels [0]\n"
+            "      <n>: 0 (only total assignments) or interval",
+            parse_size, &theory->config.check_interval, false, "<n>"));
+        handle_error(clingo_options_add_flag(options, group, "activity",
+            "Decide on variables involved in many XOR conflicts first [no]",
+            &theory->config.activity));
+        handle_error(clingo_options_add_flag(options, group, "phase",
+            "Take decision polarities from the XOR assignment [no]",
+            &theory->config.phase));
+        handle_error(clingo_options_add_flag(options, group, "propagate-binary",
+            "Derive equivalences from rows with two unassigned variables [no]",
+            &theory->config.propagate_binary));
+        handle_error(clingo_options_add_flag(options, group, "shortest-conflict",
+            "Select the shortest conflict among the conflicting rows [no]",
+            &theory->config.shortest_conflict));
+        handle_error(clingo_options_add_flag(options, group, "equivalences",
+            "Substitute equivalences from binary XOR constraints [yes]",
+            &theory->config.equivalences));
+        handle_error(clingo_options_add_flag(options, group, "eliminate",
+            "Merge XOR constraints and eliminate auxiliary variables [no]",
+            &theory->config.eliminate));
+        handle_error(clingo_options_add_flag(options, group, "dense",
+            "Use a dense tableau for problems with at most 512 variables [yes]",
+            &theory->config.dense));
+        handle_error(clingo_options_add(options, group, "watched-length",
+            "Propagate XOR constraints with at most <n> variables\n"
+            "      using watched columns instead of the engine [0]",
+            parse_size, &theory->config.watched_length, false, "<n>"));
+        handle_error(clingo_options_add(options, group, "translate",
+            "Translate XOR constraints with at most <n> literals into clauses [0]\n"
+            "      <n>: at most 20",
+            parse_translate, &theory->config.translate, false, "<n>"));
+        handle_error(clingo_options_add(options, group, "cut",
+            "Cut XOR constraints with more than <n> literals into chains [0]\n"
+            "      <n>: 0 (no cutting) or at least 3",
+            parse_cut, &theory->config.cut, false, "<n>"));
+        handle_error(clingo_options_add(options, group, "clause-type",
+            "Select the type of conflict and reason clauses [learnt]\n"
+            "      <arg>: {learnt,static,volatile,volatile-static}\n"
+            "        learnt         : subject to deletion\n"
+            "        static         : not subject to deletion\n"
+            "        volatile       : learnt, removed after the solve call\n"
+            "        volatile-static: static, removed after the solve call",
+            parse_clause_type, &theory->config.clause_type, false, "<arg>"));
+        handle_error(clingo_options_add(options, group, "reason-length",
+            "Do not add reasons with more than <n> literals [0]\n"
+            "      <n>: 0 (no limit) or maximum length",
+            parse_size, &theory->config.reason_length, false, "<n>"));
+        handle_error(clingo_options_add(options, group, "pivot-budget",
+            "Pivot at most <n> times per propagation [0]\n"
+            "      <n>: 0 (no limit) or maximum number of pivots",
+            parse_size, &theory->config.pivot_budget, false, "<n>"));
+        handle_error(clingo_options_add(options, group, "refactor",
+            "Refactor the tableau when its size exceeds the initial size by <f> [0]\n"
+            "      <f>: 0 (only on level 0) or at least 1",
+            parse_factor, &theory->config.refactor, false, "<f>"));
+        handle_error(clingo_options_add(options, group, "revert",
+            "Revert the pivots of a level when backtracking if the tableau grew by <f> [0]\n"
+            "      <f>: 0 (never) or at least 1",
+            parse_factor, &theory->config.revert, false, "<f>"));
     }
     CLINGOXOR_CATCH;
 }
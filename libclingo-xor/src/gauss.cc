@@ -0,0 +1,395 @@
+#include "gauss.hh"
+
+GaussSolver::GaussSolver(XORStore const &inequalities, Config const &config)
+: inequalities_{inequalities}
+, clause_type_{config.clause_type}
+, reason_length_{config.reason_length}
+, activity_enabled_{config.activity} {
+}
+
+Value GaussSolver::get_value(index_t i) const {
+    return Value{values_.test(i)};
+}
+
+Clingo::literal_t GaussSolver::decide(Clingo::Assignment const &ass) {
+    if (!activity_enabled_) {
+        return 0;
+    }
+    return activity_.decide(ass, [&](index_t j) { return values_.test(j); });
+}
+
+Statistics const &GaussSolver::statistics() const {
+    return statistics_;
+}
+
+bool GaussSolver::prepare(Clingo::PropagateInit &init) {
+    auto ass = init.assignment();
+
+    auto add_bound = [&](index_t j, Clingo::literal_t lit, Value value) {
+        lit_bounds_.emplace(lit, bounds_.size());
+        bounds_.emplace_back(Bound{value, j, lit});
+    };
+
+    // add bounds for variable columns
+    n_variables_ = static_cast<index_t>(inequalities_.n_variables());
+    for (index_t j = 0; j != n_variables_; ++j) {
+        auto lit = inequalities_.variable(j);
+        if (!ass.is_false(-lit)) {
+            add_bound(j, -lit, Value{false});
+        }
+        if (!ass.is_false(lit)) {
+            add_bound(j, lit, Value{true});
+        }
+    }
+
+    // select the constraints that become rows
+    std::vector<index_t> rows;
+    BitSet lhs;
+    lhs.resize(n_variables_);
+    for (size_t k = 0, e = inequalities_.size(); k != e; ++k) {
+        auto x = inequalities_[k];
+        if (ass.is_false(x.lit)) {
+            continue;
+        }
+        for (auto j : x.lhs) {
+            lhs.flip(j);
+        }
+        bool empty = BitSet::find_first(0, n_variables_, [&](size_t w) { return lhs.word(w); }) == n_variables_;
+        for (auto j : x.lhs) {
+            lhs.reset(j);
+        }
+        // check bound against 0
+        if (empty) {
+            if (x.rhs && !init.add_clause({-x.lit})) {
+                return false;
+            }
+            continue;
+        }
+        rows.emplace_back(k);
+    }
+
+    // setup the matrix with the slack columns as initial basis
+    auto n_rows = static_cast<index_t>(rows.size());
+    n_columns_ = n_variables_ + n_rows;
+    matrix_.resize(n_rows);
+    basic_.resize(n_rows);
+    watched_.resize(n_rows, none);
+    row_.resize(n_columns_, none);
+    watches_.resize(n_columns_);
+    assigned_.resize(n_columns_);
+    values_.resize(n_columns_);
+    lits_.resize(n_columns_, 0);
+    positions_.resize(n_columns_, 0);
+    seen_.resize(n_rows);
+    for (index_t i = 0; i != n_rows; ++i) {
+        auto x = inequalities_[rows[i]];
+        auto &row = matrix_[i];
+        row.resize(n_columns_);
+        for (auto j : x.lhs) {
+            row.flip(j);
+        }
+        statistics_.tableau_initial += x.lhs.size();
+        auto s = n_variables_ + i;
+        row.set(s);
+        basic_[i] = s;
+        row_[s] = i;
+        slack_bounds_.emplace_back(bounds_.size());
+        add_bound(s, x.lit, x.rhs);
+        watch_(i, find_unassigned_(i, none));
+    }
+
+    assert_extra(check_matrix_());
+
+    if (activity_enabled_) {
+        activity_.init(inequalities_);
+    }
+
+    statistics_.basic = n_rows;
+    statistics_.non_basic = n_variables_;
+    statistics_.bounds = bounds_.size();
+    statistics_.tableau_average = static_cast<double>(statistics_.tableau_initial);
+    statistics_.tableau_average_n = 1;
+
+    return true;
+}
+
+index_t GaussSolver::find_unassigned_(index_t i, index_t j) const {
+    auto const &row = matrix_[i];
+    auto b = basic_[i];
+    for (size_t k = 0; ; ++k) {
+        k = BitSet::find_first(k, n_columns_, [&](size_t w) { return row.word(w) & ~assigned_.word(w); });
+        if (k == n_columns_) {
+            return none;
+        }
+        if (k != b && k != j) {
+            return static_cast<index_t>(k);
+        }
+    }
+}
+
+void GaussSolver::watch_(index_t i, index_t j) {
+    watched_[i] = j;
+    if (j != none) {
+        watches_[j].emplace_back(i);
+    }
+}
+
+void GaussSolver::pivot_(index_t i, index_t j) {
+    assert(row_[j] == none && matrix_[i].test(j));
+    row_[basic_[i]] = none;
+    row_[j] = i;
+    basic_[i] = j;
+    auto const &pivot = matrix_[i];
+    for (index_t r = 0, e = static_cast<index_t>(matrix_.size()); r != e; ++r) {
+        if (r != i && matrix_[r].test(j)) {
+            matrix_[r] ^= pivot;
+            dirty_.emplace_back(r);
+        }
+    }
+    ++statistics_.pivots;
+}
+
+bool GaussSolver::propagate_row_(Clingo::PropagateControl &ctl, index_t i) {
+    auto const &row = matrix_[i];
+    auto b = basic_[i];
+    Value sum;
+    index_t latest = none;
+    clause_.clear();
+    for (size_t k = BitSet::find_first(0, n_columns_, [&](size_t w) { return row.word(w); });
+         k != n_columns_;
+         k = BitSet::find_first(k + 1, n_columns_, [&](size_t w) { return row.word(w); })) {
+        if (k == b) {
+            continue;
+        }
+        assert(assigned_.test(k));
+        sum ^= Value{values_.test(k)};
+        clause_.emplace_back(-lits_[k]);
+        if (latest == none || positions_[latest] < positions_[k]) {
+            latest = static_cast<index_t>(k);
+        }
+    }
+    // Note: The row is watched by its most recently assigned non-basic
+    // column so that it is revisited once this column is unassigned.
+    if (latest != none && latest != watched_[i]) {
+        watch_(i, latest);
+    }
+
+    // the row is conflicting or satisfied
+    if (assigned_.test(b)) {
+        if (Value{values_.test(b)} == sum) {
+            return true;
+        }
+        ++statistics_.unsat;
+        clause_.emplace_back(-lits_[b]);
+        statistics_.add_conflict(clause_.size());
+        if (activity_enabled_) {
+            activity_.bump(clause_);
+        }
+        return add_clause(ctl, clause_, clause_type_, reason_length_, true, statistics_);
+    }
+
+    // the row is unit
+    if (b < n_variables_) {
+        auto lit = inequalities_.variable(b);
+        clause_.emplace_back(sum ? lit : -lit);
+    }
+    else {
+        // Note: Nothing can be derived if the value of the slack column
+        // agrees with the right-hand side because the constraint only has to
+        // hold if its literal is true.
+        auto const &bound = bounds_[slack_bounds_[b - n_variables_]];
+        if (bound.value == sum) {
+            return true;
+        }
+        clause_.emplace_back(-bound.lit);
+    }
+    if (ctl.assignment().is_true(clause_.back())) {
+        return true;
+    }
+    return add_clause(ctl, clause_, clause_type_, reason_length_, false, statistics_);
+}
+
+bool GaussSolver::update_row_(Clingo::PropagateControl &ctl, index_t i) {
+    auto b = basic_[i];
+    auto w = watched_[i];
+    if (!assigned_.test(b) && w != none && !assigned_.test(w) && matrix_[i].test(w)) {
+        return true;
+    }
+    auto j = find_unassigned_(i, none);
+    if (j == none) {
+        return propagate_row_(ctl, i);
+    }
+    if (assigned_.test(b)) {
+        pivot_(i, j);
+        j = find_unassigned_(i, none);
+        if (j == none) {
+            return propagate_row_(ctl, i);
+        }
+    }
+    watch_(i, j);
+    return true;
+}
+
+bool GaussSolver::update_(Clingo::PropagateControl &ctl) {
+    // Note: If a conflict is found, the remaining rows stay in the list and
+    // are updated on the next call. Their content has changed and their
+    // watches might no longer be valid.
+    while (!dirty_.empty()) {
+        auto i = dirty_.back();
+        dirty_.pop_back();
+        if (!update_row_(ctl, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GaussSolver::update_column_(Clingo::PropagateControl &ctl, index_t j) {
+    if (row_[j] != none) {
+        dirty_.emplace_back(row_[j]);
+        if (!update_(ctl)) {
+            return false;
+        }
+    }
+
+    // remove stale and duplicate entries from the watch list
+    auto &watches = watches_[j];
+    auto jt = watches.begin();
+    for (auto i : watches) {
+        if (watched_[i] == j && !seen_.test(i)) {
+            seen_.set(i);
+            *jt++ = i;
+        }
+    }
+    watches.erase(jt, watches.end());
+    for (auto i : watches) {
+        seen_.reset(i);
+    }
+
+    // Note: Updating rows never adds watches for column j because it is
+    // assigned. Rows that keep watching the column stay in the list.
+    size_t out = 0;
+    for (size_t k = 0, e = watches.size(); k != e; ++k) {
+        auto i = watches[k];
+        if (watched_[i] != j) {
+            continue;
+        }
+        dirty_.emplace_back(i);
+        bool ret = update_(ctl);
+        if (watched_[i] == j) {
+            watches[out++] = i;
+        }
+        if (!ret) {
+            watches.erase(watches.begin() + out, watches.begin() + k + 1); // NOLINT
+            return false;
+        }
+    }
+    watches.resize(out);
+    return true;
+}
+
+bool GaussSolver::solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits) {
+    auto timer = statistics_.total.start();
+    auto ass = ctl.assignment();
+    auto level = ass.decision_level();
+
+    // Note: Levels that have been backtracked without a call to undo are
+    // undone here.
+    if (!trail_offset_.empty() && trail_offset_.back().level > level) {
+        undo(level + 1);
+    }
+    if (trail_offset_.empty() || trail_offset_.back().level < level) {
+        trail_offset_.emplace_back(TrailOffset{level, static_cast<index_t>(assignment_trail_.size())});
+    }
+
+    // assign columns
+    auto offset = assignment_trail_.size();
+    for (auto lit : lits) {
+        for (auto [it, ie] = lit_bounds_.equal_range(lit); it != ie; ++it) {
+            auto const &bound = bounds_[it->second];
+            auto j = bound.column;
+            if (assigned_.test(j)) {
+                if (Value{values_.test(j)} != bound.value) {
+                    clause_.clear();
+                    clause_.emplace_back(-bound.lit);
+                    clause_.emplace_back(-lits_[j]);
+                    statistics_.add_conflict(clause_.size());
+                    if (activity_enabled_) {
+                        activity_.bump(clause_);
+                    }
+                    add_clause(ctl, clause_, clause_type_, reason_length_, true, statistics_);
+                    return false;
+                }
+                continue;
+            }
+            assigned_.set(j);
+            values_.assign(j, static_cast<bool>(bound.value));
+            lits_[j] = bound.lit;
+            positions_[j] = static_cast<index_t>(assignment_trail_.size());
+            assignment_trail_.emplace_back(j);
+        }
+    }
+
+    // update rows
+    auto timer_propagate = statistics_.propagate.start();
+    if (!update_(ctl)) {
+        return false;
+    }
+    for (auto it = assignment_trail_.begin() + offset, ie = assignment_trail_.end(); it != ie; ++it) {
+        if (!update_column_(ctl, *it)) {
+            return false;
+        }
+    }
+
+    assert_extra(check_matrix_());
+
+    ++statistics_.sat;
+    return true;
+}
+
+bool GaussSolver::finish(Clingo::PropagateControl &ctl) {
+    // Note: Rows are always updated completely.
+    static_cast<void>(ctl);
+    return true;
+}
+
+void GaussSolver::undo(index_t level) {
+    if (activity_enabled_) {
+        activity_.restore();
+    }
+    if (trail_offset_.empty() || trail_offset_.back().level < level) {
+        return;
+    }
+    auto it_offset = trail_offset_.end();
+    while (it_offset != trail_offset_.begin() && std::prev(it_offset)->level >= level) {
+        --it_offset;
+    }
+    for (auto it = assignment_trail_.begin() + it_offset->assignment, ie = assignment_trail_.end(); it != ie; ++it) {
+        assigned_.reset(*it);
+    }
+    assignment_trail_.resize(it_offset->assignment);
+    trail_offset_.erase(it_offset, trail_offset_.end());
+}
+
+bool GaussSolver::check_matrix_() const {
+    for (index_t i = 0, e = static_cast<index_t>(matrix_.size()); i != e; ++i) {
+        auto b = basic_[i];
+        if (row_[b] != i || !matrix_[i].test(b)) {
+            return false;
+        }
+        for (index_t r = 0; r != e; ++r) {
+            if (r != i && matrix_[r].test(b)) {
+                return false;
+            }
+        }
+        // rows with an unassigned basic column watch an unassigned column
+        // if there is one
+        if (!assigned_.test(b) && find_unassigned_(i, none) != none) {
+            auto w = watched_[i];
+            if (w == none || assigned_.test(w) || !matrix_[i].test(w)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "solving.hh"
+
+#include <unordered_map>
+
+//! A solver propagating XOR constraints using Gauss-Jordan elimination.
+//!
+//! Each constraint `lhs = rhs :- lit` is represented by a row `lhs + s = 0`
+//! in a dense matrix where the slack column `s` is assigned `rhs` if `lit`
+//! is true. The matrix is kept in reduced row-echelon form, where each row
+//! has a basic column that does not occur in any other row. Furthermore,
+//! each row watches one unassigned non-basic column. While the basic and
+//! the watched column of a row are unassigned, nothing can be derived from
+//! the row. Once one of them is assigned, another unassigned column is
+//! searched. If there is none, the row is unit or conflicting. If the basic
+//! column is assigned, it is replaced by an unassigned column via a pivot.
+//!
+//! In contrast to the simplex-based solver, units and conflicts are
+//! detected eagerly. Pivots do not have to be undone when backtracking
+//! because any basis is a valid representation of the constraints.
+class GaussSolver final : public AbstractSolver {
+private:
+    //! Associates a literal with the value it assigns to a column.
+    struct Bound {
+        Value value;
+        index_t column{0};
+        Clingo::literal_t lit{0};
+    };
+    struct TrailOffset {
+        index_t level;
+        index_t assignment;
+    };
+    //! Marker for missing columns and rows.
+    static constexpr index_t none = std::numeric_limits<index_t>::max();
+
+public:
+    //! Construct a new solver object.
+    GaussSolver(XORStore const &inequalities, Config const &config);
+
+    [[nodiscard]] bool prepare(Clingo::PropagateInit &init) override;
+    [[nodiscard]] bool solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits) override;
+    [[nodiscard]] bool finish(Clingo::PropagateControl &ctl) override;
+    void undo(index_t level) override;
+    [[nodiscard]] Value get_value(index_t i) const override;
+    [[nodiscard]] Clingo::literal_t decide(Clingo::Assignment const &ass) override;
+    [[nodiscard]] Statistics const &statistics() const override;
+
+private:
+    //! Check if the matrix is in reduced row-echelon form and the watches
+    //! are consistent.
+    [[nodiscard]] bool check_matrix_() const;
+
+    //! Find an unassigned column in row `i` other than its basic column and
+    //! column `j`.
+    [[nodiscard]] index_t find_unassigned_(index_t i, index_t j) const;
+    //! Let row `i` watch column `j`.
+    void watch_(index_t i, index_t j);
+    //! Make column `j` the basic column of row `i`.
+    void pivot_(index_t i, index_t j);
+    //! Restore the invariants of row `i` after one of its columns has been
+    //! assigned or the row has changed.
+    //!
+    //! Returns false if a conflict has been found.
+    [[nodiscard]] bool update_row_(Clingo::PropagateControl &ctl, index_t i);
+    //! Update the rows in the dirty list including rows changed by pivots
+    //! in turn.
+    [[nodiscard]] bool update_(Clingo::PropagateControl &ctl);
+    //! Update the rows in which column `j` is basic or watched after it has
+    //! been assigned.
+    [[nodiscard]] bool update_column_(Clingo::PropagateControl &ctl, index_t j);
+    //! Add a clause forcing the basic column of row `i` or, if it is
+    //! assigned, a conflict clause for the row.
+    [[nodiscard]] bool propagate_row_(Clingo::PropagateControl &ctl, index_t i);
+
+    //! The XOR constraints.
+    XORStore const &inequalities_;
+    //! The rows of the matrix.
+    std::vector<BitSet> matrix_;
+    //! The basic column of each row.
+    std::vector<index_t> basic_;
+    //! The watched column of each row.
+    std::vector<index_t> watched_;
+    //! The row of each basic column.
+    std::vector<index_t> row_;
+    //! The rows watching a column.
+    //!
+    //! The lists are cleaned up lazily and might contain rows that no longer
+    //! watch the column.
+    std::vector<std::vector<index_t>> watches_;
+    //! The bounds associated with variable and slack columns.
+    std::vector<Bound> bounds_;
+    //! The bound associated with the slack column of each row.
+    std::vector<index_t> slack_bounds_;
+    //! Map from literals to corresponding bounds.
+    std::unordered_multimap<Clingo::literal_t, index_t> lit_bounds_;
+    //! The assigned columns.
+    BitSet assigned_;
+    //! The values of the assigned columns.
+    BitSet values_;
+    //! The literals that assigned the columns.
+    std::vector<Clingo::literal_t> lits_;
+    //! The assigned columns in chronological order.
+    std::vector<index_t> assignment_trail_;
+    //! The position of each assigned column on the trail.
+    std::vector<index_t> positions_;
+    //! Offsets into the assignment trail for each decision level.
+    std::vector<TrailOffset> trail_offset_;
+    //! Rows that have to be updated, e.g., because they were changed by a
+    //! pivot.
+    std::vector<index_t> dirty_;
+    //! Marks rows when cleaning up watch lists.
+    BitSet seen_;
+    //! The clause to add.
+    std::vector<Clingo::literal_t> clause_;
+    //! Problem and solving statistics.
+    Statistics statistics_;
+    //! The number of variable columns.
+    index_t n_variables_{0};
+    //! The number of columns.
+    index_t n_columns_{0};
+    //! The type of added clauses.
+    Clingo::ClauseType clause_type_;
+    //! The maximum length of added reasons.
+    size_t reason_length_;
+    //! The conflict activity of the variables.
+    ConflictActivity activity_;
+    //! Whether conflict activities are maintained.
+    bool activity_enabled_;
+};
@@ -5,6 +5,13 @@
 
 namespace {
 
+//! The minimum number of theory atoms to evaluate them in parallel.
+constexpr size_t parallel_threshold = 64;
+//! The maximum number of theory atoms evaluated at once.
+//!
+//! This bounds the memory needed for intermediate results.
+constexpr size_t chunk_size = 4096;
+
 template <typename T=void>
 [[nodiscard]] T throw_syntax_error(char const *message="Invalid Syntax") {
     throw std::runtime_error(message);
@@ -61,112 +68,254 @@ bool is_string(Clingo::TheoryTerm const &term) {
     return throw_syntax_error<Clingo::Symbol>();
 }
 
-} // namespace
+//! The result of evaluating a single theory atom.
+//!
+//! This captures everything that can be computed without modifying the
+//! solver. Element conditions with an odd number of occurrences are kept in
+//! `elems`; an empty condition is accounted for in `rhs`.
+struct AtomBuffer {
+    Clingo::literal_t lit{0};
+    Value rhs;
+    std::vector<std::vector<Clingo::literal_t>> elems;
+};
 
-void evaluate_theory(Clingo::PropagateInit &init, VarMap &var_map, std::vector<XORConstraint> &iqs) {
-    auto theory = init.theory_atoms();
-    auto ass = init.assignment();
-    for (auto &&atom : theory) {
-        bool even = match(atom.term(), "even", 0);
-        bool odd  = match(atom.term(), "odd", 0);
-        if (even || odd) {
-            auto lit = init.solver_literal(atom.literal());
-            if (ass.is_false(lit)) {
-                continue;
-            }
+//! Evaluate the given theory atom into the given buffer.
+//!
+//! Note that this function only reads from the theory and the assignment and
+//! can be called concurrently for different atoms. Evaluating tuples creates
+//! symbols, which relies on clingo's symbol table being thread-safe.
+void evaluate_atom(Clingo::PropagateInit const &init, Clingo::TheoryAtom const &atom, AtomBuffer &buf) {
+    bool even = match(atom.term(), "even", 0);
+    bool odd  = match(atom.term(), "odd", 0);
+    if (!even && !odd) {
+        return;
+    }
+    auto lit = init.solver_literal(atom.literal());
+    if (init.assignment().is_false(lit)) {
+        return;
+    }
 
-            // map from tuples to condition
-            std::map<std::vector<Clingo::Symbol>, size_t> elem_ids;
-            std::vector<std::vector<Clingo::literal_t>> elems;
-            for (auto &&elem : atom.elements()) {
-                check_syntax(!elem.tuple().empty());
-                std::vector<Clingo::Symbol> tuple;
-                tuple.reserve(elem.tuple().size());
-                for (auto &&term : elem.tuple()) {
-                    tuple.emplace_back(evaluate(term));
-                }
-                auto res = elem_ids.emplace(std::move(tuple), elems.size());
-                auto xor_lit = elem.condition().empty() ? 0 : init.solver_literal(elem.condition_id());
-                if (res.second) {
-                    elems.emplace_back();
-                    if (xor_lit != 0) {
-                        elems.back().emplace_back(xor_lit);
-                    }
-                }
-                else {
-                    auto &lits = elems[res.first->second];
-                    if (xor_lit != 0) {
-                        lits.emplace_back(xor_lit);
-                    }
-                    else {
-                        lits.clear();
-                    }
-                }
+    // map from tuples to condition
+    std::map<std::vector<Clingo::Symbol>, size_t> elem_ids;
+    std::vector<std::vector<Clingo::literal_t>> elems;
+    std::vector<bool> facts;
+    for (auto &&elem : atom.elements()) {
+        check_syntax(!elem.tuple().empty());
+        std::vector<Clingo::Symbol> tuple;
+        tuple.reserve(elem.tuple().size());
+        for (auto &&term : elem.tuple()) {
+            tuple.emplace_back(evaluate(term));
+        }
+        auto res = elem_ids.emplace(std::move(tuple), elems.size());
+        auto xor_lit = elem.condition().empty() ? 0 : init.solver_literal(elem.condition_id());
+        if (res.second) {
+            elems.emplace_back();
+            facts.emplace_back(xor_lit == 0);
+            if (xor_lit != 0) {
+                elems.back().emplace_back(xor_lit);
             }
-            // sort conditions and find duplicates
-            std::map<std::reference_wrapper<std::vector<Clingo::literal_t>>, size_t, std::less<std::vector<Clingo::literal_t>>> seen; // NOLINT
-            for (auto &lits : elems) {
-                std::sort(lits.begin(), lits.end());
-                lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
-                seen[lits] += 1;
+        }
+        // once a tuple has an empty condition, further conditions are irrelevant
+        else if (!facts[res.first->second]) {
+            auto &lits = elems[res.first->second];
+            if (xor_lit != 0) {
+                lits.emplace_back(xor_lit);
+            }
+            else {
+                lits.clear();
+                facts[res.first->second] = true;
             }
+        }
+    }
+    // sort conditions and find duplicates
+    std::map<std::reference_wrapper<std::vector<Clingo::literal_t>>, size_t, std::less<std::vector<Clingo::literal_t>>> seen; // NOLINT
+    for (auto &lits : elems) {
+        std::sort(lits.begin(), lits.end());
+        lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+        seen[lits] += 1;
+    }
+
+    // gather conditions with odd number of occurrences
+    // (note that the conditions cannot be moved while the map refers to them)
+    buf.lit = lit;
+    buf.rhs = Value{odd};
+    for (auto &&lits : elems) {
+        auto it = seen.find(lits);
+        if (it->second % 2 == 0) {
+            continue;
+        }
+        it->second = 0;
+        if (lits.empty()) {
+            buf.rhs.flip();
+            continue;
+        }
+        buf.elems.emplace_back(lits);
+    }
+}
 
-            // gather literals for XOR constraint
-            Value rhs{odd};
-            std::vector<Clingo::literal_t> lhs_lits;
-            for (auto &&lits : elems) {
-                auto it = seen.find(lits);
-                if (it->second % 2 == 0) {
-                    continue;
-                }
-                it->second = 0;
-                if (lits.empty()) {
-                    rhs.flip();
-                    continue;
-                }
-                Clingo::literal_t xor_lit{0};
-                if (lits.size() == 1) {
-                    lhs_lits.emplace_back(lits.front());
-                    continue;
-                }
-                xor_lit = init.add_literal();
-                std::vector<Clingo::literal_t> clause;
-                clause.reserve(lits.size() + 1);
-                clause.emplace_back(-xor_lit);
-                for (auto &&eq_lit : lits) {
-                    clause.emplace_back(eq_lit);
-                    init.add_clause({-eq_lit, xor_lit});
-                }
-                init.add_clause(clause);
-                lhs_lits.emplace_back(xor_lit);
+//! Add clauses equivalent to XOR constraint `lits = rhs :- lit`.
+//!
+//! There is one clause for each assignment violating the constraint. Thus,
+//! the number of clauses is exponential in the number of literals.
+[[nodiscard]] bool translate_xor(Clingo::PropagateInit &init, std::vector<Clingo::literal_t> const &lits, Value rhs, Clingo::literal_t lit) {
+    bool cond = !init.assignment().is_true(lit);
+    std::vector<Clingo::literal_t> clause;
+    clause.reserve(lits.size() + 1);
+    for (uint64_t mask = 0, e = uint64_t{1} << lits.size(); mask != e; ++mask) {
+        Value parity;
+        clause.clear();
+        if (cond) {
+            clause.emplace_back(-lit);
+        }
+        for (size_t i = 0, n = lits.size(); i != n; ++i) {
+            if (((mask >> i) & 1U) != 0) {
+                parity.flip();
+                clause.emplace_back(-lits[i]);
+            }
+            else {
+                clause.emplace_back(lits[i]);
             }
+        }
+        if (parity != rhs && !init.add_clause(clause)) {
+            return false;
+        }
+    }
+    return true;
+}
 
-            // build XOR constraint over intermediate variables
-            if (lhs_lits.empty()) {
-                if (rhs && !init.add_clause({-lit})) {
-                    return;
-                }
-                continue;
+//! Add XOR constraint `lits = rhs :- lit`.
+//!
+//! Short constraints are translated into clauses and all others are added
+//! to the store.
+[[nodiscard]] bool add_xor(Clingo::PropagateInit &init, Config const &config, std::vector<Clingo::literal_t> const &lits, Value rhs, Clingo::literal_t lit, VarMap &var_map, XORStore &iqs, std::vector<index_t> &lhs_syms) {
+    if (lits.empty()) {
+        return !rhs || init.add_clause({-lit});
+    }
+    if (lits.size() == 1) {
+        auto xor_lit = lits.front();
+        return init.add_clause({-lit, rhs ? xor_lit : -xor_lit});
+    }
+    if (lits.size() <= config.translate) {
+        return translate_xor(init, lits, rhs, lit);
+    }
+    lhs_syms.clear();
+    for (auto eq_lit : lits) {
+        auto res = var_map.try_emplace(eq_lit, 0);
+        if (res.second) {
+            res.first->second = iqs.add_variable(eq_lit);
+        }
+        lhs_syms.emplace_back(res.first->second);
+    }
+    iqs.add(lhs_syms.begin(), lhs_syms.end(), rhs, lit);
+    return true;
+}
+
+//! Add the XOR constraint captured by the given buffer.
+//!
+//! This introduces auxiliary literals and clauses and has to be called
+//! sequentially. The given true literal is introduced on demand. Returns
+//! false if the problem became unsatisfiable.
+[[nodiscard]] bool add_atom(Clingo::PropagateInit &init, Config const &config, AtomBuffer const &buf, VarMap &var_map, XORStore &iqs, std::vector<index_t> &lhs_syms, Clingo::literal_t &true_lit) {
+    auto lit = buf.lit;
+    auto rhs = buf.rhs;
+
+    // gather literals for XOR constraint
+    std::vector<Clingo::literal_t> lhs_lits;
+    for (auto &&lits : buf.elems) {
+        if (lits.size() == 1) {
+            lhs_lits.emplace_back(lits.front());
+            continue;
+        }
+        auto xor_lit = init.add_literal();
+        std::vector<Clingo::literal_t> clause;
+        clause.reserve(lits.size() + 1);
+        clause.emplace_back(-xor_lit);
+        for (auto &&eq_lit : lits) {
+            clause.emplace_back(eq_lit);
+            init.add_clause({-eq_lit, xor_lit});
+        }
+        init.add_clause(clause);
+        lhs_lits.emplace_back(xor_lit);
+    }
+
+    // Cut long constraints into a chain of constraints. The first
+    // `config.cut - 1` literals are replaced by an auxiliary literal that is
+    // defined as their sum. The definitions hold unconditionally.
+    if (config.cut > 0 && lhs_lits.size() > config.cut) {
+        if (true_lit == 0) {
+            true_lit = init.add_literal();
+            if (!init.add_clause({true_lit})) {
+                return false;
+            }
+        }
+        // The auxiliary literals only occur in the resulting constraints if
+        // none of them is translated into clauses.
+        auto n = lhs_lits.size();
+        while (n > config.cut) {
+            n -= config.cut - 2;
+        }
+        bool auxiliary = config.cut > config.translate && n > config.translate;
+        std::vector<Clingo::literal_t> piece;
+        auto it = lhs_lits.begin();
+        auto ie = lhs_lits.end();
+        while (static_cast<size_t>(ie - it) > config.cut) {
+            auto aux = init.add_literal();
+            if (auxiliary) {
+                var_map.emplace(aux, iqs.add_variable(aux, true));
             }
-            if (lhs_lits.size() == 1) {
-                auto xor_lit = lhs_lits.front();
-                if (!init.add_clause({-lit, rhs ? xor_lit : -xor_lit})) {
-                    return;
-                }
-                continue;
+            piece.assign(it, it + config.cut - 1);
+            piece.emplace_back(aux);
+            if (!add_xor(init, config, piece, Value{false}, true_lit, var_map, iqs, lhs_syms)) {
+                return false;
             }
-            std::vector<index_t> lhs_syms;
-            for (auto eq_lit : lhs_lits) {
-                auto res = var_map.try_emplace(eq_lit, var_map.size());
-                if (res.second) {
-                    // Note: With this setup, variables can have at most two
-                    // bounds. Data structures could be optimized for this.
-                    iqs.emplace_back(XORConstraint{{res.first->second}, Value{false}, -eq_lit});
-                    iqs.emplace_back(XORConstraint{{res.first->second}, Value{true}, eq_lit});
-                }
-                lhs_syms.emplace_back(res.first->second);
+            it += config.cut - 2;
+            *it = aux;
+        }
+        lhs_lits.erase(lhs_lits.begin(), it);
+    }
+
+    // build XOR constraint over intermediate variables
+    return add_xor(init, config, lhs_lits, rhs, lit, var_map, iqs, lhs_syms);
+}
+
+} // namespace
+
+void evaluate_theory(Clingo::PropagateInit &init, VarMap &var_map, XORStore &iqs, Config const &config) {
+    std::vector<Clingo::TheoryAtom> atoms;
+    std::vector<AtomBuffer> bufs;
+    std::vector<index_t> lhs_syms;
+    Clingo::literal_t true_lit = 0;
+    atoms.reserve(chunk_size);
+
+    // Atoms are processed in chunks so that only the intermediate results of
+    // one chunk have to be kept in memory. They are directly converted into
+    // the compact constraint store.
+    auto theory = init.theory_atoms();
+    for (auto it = theory.begin(), ie = theory.end(); it != ie; ) {
+        atoms.clear();
+        for (; it != ie && atoms.size() < chunk_size; ++it) {
+            atoms.emplace_back(*it);
+        }
+
+        // Atoms are evaluated independently in parallel. Only a handful of
+        // atoms is not worth starting threads for.
+        size_t n_threads = 1;
+        if (atoms.size() >= parallel_threshold) {
+            n_threads = config.parse_threads > 0 ? config.parse_threads : std::max(std::thread::hardware_concurrency(), 1U);
+        }
+        bufs.clear();
+        bufs.resize(atoms.size());
+        parallel_for(atoms.size(), n_threads, [&](size_t i) {
+            evaluate_atom(init, atoms[i], bufs[i]);
+        });
+
+        // Auxiliary literals, clauses, and variables are added sequentially
+        // in the order of the atoms to obtain deterministic variable indices.
+        for (auto &buf : bufs) {
+            if (buf.lit != 0 && !add_atom(init, config, buf, var_map, iqs, lhs_syms, true_lit)) {
+                return;
             }
-            iqs.emplace_back(XORConstraint{std::move(lhs_syms), rhs, lit});
         }
     }
+    iqs.shrink_to_fit();
 }
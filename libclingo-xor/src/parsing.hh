@@ -14,4 +14,8 @@ constexpr char const *THEORY = R"(
 
 using VarMap = std::map<Clingo::literal_t, index_t>;
 
-void evaluate_theory(Clingo::PropagateInit &init, VarMap &var_map, std::vector<XORConstraint> &iqs);
+//! Evaluate the XOR theory atoms and add them to the store.
+//!
+//! Depending on the configuration, short constraints are translated into
+//! clauses and long constraints are cut into chains of shorter ones.
+void evaluate_theory(Clingo::PropagateInit &init, VarMap &var_map, XORStore &iqs, Config const &config = Config{});
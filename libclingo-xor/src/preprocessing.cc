@@ -0,0 +1,233 @@
+#include "preprocessing.hh"
+
+#include <map>
+#include <iterator>
+
+namespace {
+
+//! Remove pairs of equal variables from the given sorted vector.
+void cancel_pairs(std::vector<index_t> &lhs) {
+    auto out = lhs.begin();
+    for (auto it = lhs.begin(), ie = lhs.end(); it != ie; ) {
+        auto jt = std::find_if(it, ie, [&](index_t x) { return x != *it; });
+        if ((jt - it) % 2 == 1) {
+            *out++ = *it;
+        }
+        it = jt;
+    }
+    lhs.erase(out, lhs.end());
+}
+
+//! The maximum number of constraints compared with each other when merging.
+//!
+//! Constraints are only compared if they share their smallest variable.
+constexpr size_t merge_bucket_size = 8;
+
+//! Compute the sum of two sorted left-hand sides.
+void add_rows(std::vector<index_t> const &a, std::vector<index_t> const &b, std::vector<index_t> &res) {
+    res.clear();
+    std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(res));
+}
+
+} // namespace
+
+std::pair<index_t, Value> EquivalenceClasses::find(index_t x) {
+    assert(x < parent_.size());
+    // find the representative
+    auto root = x;
+    Value parity;
+    while (parent_[root] != root) {
+        parity ^= Value{parity_[root]};
+        root = parent_[root];
+    }
+    // compress the path
+    auto y = x;
+    auto p = parity;
+    while (parent_[y] != y) {
+        auto next = parent_[y];
+        auto next_p = p ^ Value{parity_[y]};
+        parent_[y] = root;
+        parity_[y] = static_cast<bool>(p);
+        y = next;
+        p = next_p;
+    }
+    return {root, parity};
+}
+
+void EquivalenceClasses::merge(index_t x, index_t y, Value parity) {
+    assert(parent_[x] == x && parent_[y] == y && x != y);
+    if (y < x) {
+        std::swap(x, y);
+    }
+    parent_[y] = x;
+    parity_[y] = static_cast<bool>(parity);
+}
+
+size_t EquivalenceClasses::size() const {
+    return parent_.size();
+}
+
+void EquivalenceClasses::resize(size_t n) {
+    for (auto x = static_cast<index_t>(parent_.size()); x < n; ++x) {
+        parent_.emplace_back(x);
+        parity_.emplace_back(false);
+    }
+}
+
+bool substitute_equivalences(Clingo::PropagateInit &init, XORStore &iqs, EquivalenceClasses &classes, PreprocessingStatistics &stats) {
+    auto ass = init.assignment();
+    classes.resize(iqs.n_variables());
+
+    // Substituting variables can produce further binary constraints. Thus,
+    // the store is rewritten until no more classes are merged.
+    bool ret = true;
+    for (bool merged = true; merged && ret; ) {
+        merged = false;
+        iqs.rewrite([&](std::vector<index_t> &lhs, Value &rhs, Clingo::literal_t lit) {
+            if (!ret) {
+                return true;
+            }
+            for (auto &x : lhs) {
+                auto [y, parity] = classes.find(x);
+                x = y;
+                rhs ^= parity;
+            }
+            std::sort(lhs.begin(), lhs.end());
+            cancel_pairs(lhs);
+            // constraints with fewer than two variables are replaced by
+            // clauses because the solvers expect rows with at least two
+            // elements
+            if (lhs.empty()) {
+                ret = !rhs || init.add_clause({-lit});
+                return !ret;
+            }
+            if (lhs.size() == 1) {
+                auto x = iqs.variable(lhs[0]);
+                ret = init.add_clause({-lit, rhs ? x : -x});
+                iqs.unset_auxiliary(lhs[0]);
+                return !ret;
+            }
+            if (lhs.size() != 2 || !ass.is_true(lit)) {
+                return true;
+            }
+            // x + y = rhs is equivalent to x = y + rhs
+            auto x = iqs.variable(lhs[0]);
+            auto y = iqs.variable(lhs[1]);
+            if (!init.add_clause({-x, rhs ? -y : y}) || !init.add_clause({x, rhs ? y : -y})) {
+                ret = false;
+                return true;
+            }
+            // the clauses above mention both variables
+            iqs.unset_auxiliary(lhs[0]);
+            iqs.unset_auxiliary(lhs[1]);
+            classes.merge(lhs[0], lhs[1], rhs);
+            ++stats.equivalences;
+            merged = true;
+            return false;
+        });
+    }
+    return ret;
+}
+
+void eliminate_variables(Clingo::PropagateInit &init, XORStore &iqs, XORStore &eliminated, PreprocessingStatistics &stats) {
+    auto ass = init.assignment();
+
+    // gather constraints that have to hold
+    std::vector<std::vector<index_t>> rows(iqs.size());
+    std::vector<Value> rhs(iqs.size());
+    std::vector<index_t> candidates;
+    std::vector<size_t> occurrences(iqs.n_variables(), 0);
+    for (size_t k = 0, e = iqs.size(); k != e; ++k) {
+        auto x = iqs[k];
+        // constraints whose literal is false never have to hold
+        if (ass.is_false(x.lit)) {
+            continue;
+        }
+        for (auto var : x.lhs) {
+            ++occurrences[var];
+        }
+        if (x.lhs.size() >= 2 && ass.is_true(x.lit)) {
+            rows[k].assign(x.lhs.begin(), x.lhs.end());
+            std::sort(rows[k].begin(), rows[k].end());
+            rhs[k] = x.rhs;
+            candidates.emplace_back(k);
+        }
+    }
+
+    // merge constraints sharing their smallest variable
+    std::map<index_t, std::vector<index_t>> buckets;
+    for (auto k : candidates) {
+        auto &bucket = buckets[rows[k].front()];
+        if (bucket.size() < merge_bucket_size) {
+            bucket.emplace_back(k);
+        }
+    }
+    std::vector<index_t> sum;
+    std::vector<bool> modified(iqs.size(), false);
+    for (auto &[var, bucket] : buckets) {
+        for (auto it = bucket.begin(), ie = bucket.end(); it != ie; ++it) {
+            for (auto jt = it + 1; jt != ie; ++jt) {
+                auto &a = rows[*it];
+                auto &b = rows[*jt];
+                add_rows(a, b, sum);
+                auto &longer = a.size() < b.size() ? b : a;
+                // Note: The solvers expect rows with at least two elements.
+                if (sum.size() < 2 || sum.size() >= longer.size()) {
+                    continue;
+                }
+                for (auto x : longer) {
+                    --occurrences[x];
+                }
+                for (auto x : sum) {
+                    ++occurrences[x];
+                }
+                auto k = &longer == &a ? *it : *jt;
+                rhs[k] = rhs[*it] ^ rhs[*jt];
+                modified[k] = true;
+                std::swap(longer, sum);
+                ++stats.merged_rows;
+            }
+        }
+    }
+
+    // Eliminate constraints with an auxiliary variable that occurs nowhere
+    // else. Program atoms are never eliminated because they might occur in
+    // rules. The eliminated constraints are no longer propagated but only
+    // checked lazily.
+    std::vector<bool> removed(iqs.size(), false);
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (auto k : candidates) {
+            auto &row = rows[k];
+            if (removed[k] || row.size() < 2) {
+                continue;
+            }
+            if (std::none_of(row.begin(), row.end(), [&](index_t x) { return occurrences[x] == 1 && iqs.auxiliary(x); })) {
+                continue;
+            }
+            for (auto x : row) {
+                if (--occurrences[x] == 0) {
+                    ++stats.eliminated_variables;
+                }
+            }
+            eliminated.add(row.begin(), row.end(), rhs[k], iqs[k].lit);
+            removed[k] = true;
+            ++stats.eliminated_rows;
+            changed = true;
+        }
+    }
+
+    // update the store
+    size_t k = 0;
+    iqs.rewrite([&](std::vector<index_t> &lhs, Value &x_rhs, Clingo::literal_t) {
+        auto i = k++;
+        if (removed[i]) {
+            return false;
+        }
+        if (modified[i]) {
+            lhs = rows[i];
+            x_rhs = rhs[i];
+        }
+        return true;
+    });
+}
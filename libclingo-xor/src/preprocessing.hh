@@ -0,0 +1,58 @@
+#pragma once
+
+#include "problem.hh"
+
+//! Statistics gathered during preprocessing.
+struct PreprocessingStatistics {
+    size_t equivalences{0};
+    size_t merged_rows{0};
+    size_t eliminated_rows{0};
+    size_t eliminated_variables{0};
+};
+
+//! Equivalence classes of variables.
+//!
+//! Each variable is associated with a representative of its class such that
+//! the value of the variable is the XOR of the value of the representative
+//! and a parity. This is a union-find data structure with path compression
+//! that additionally tracks parities.
+class EquivalenceClasses {
+public:
+    //! Find the representative of variable `x` and the parity of `x`
+    //! relative to it.
+    [[nodiscard]] std::pair<index_t, Value> find(index_t x);
+
+    //! Merge the classes of representatives `x` and `y` such that
+    //! `x + y = parity` holds.
+    //!
+    //! The variable with the smaller index becomes the representative.
+    void merge(index_t x, index_t y, Value parity);
+
+    //! Get the number of variables.
+    [[nodiscard]] size_t size() const;
+
+    //! Ensure that the data structure can hold `n` variables.
+    void resize(size_t n);
+
+private:
+    std::vector<index_t> parent_;
+    std::vector<bool> parity_;
+};
+
+//! Substitute variables that are equivalent because of binary XOR
+//! constraints whose literal is true on level 0.
+//!
+//! The equivalences are added as clauses and removed from the store. In the
+//! remaining constraints, variables are replaced by their representatives.
+//! Constraints left with fewer than two variables are replaced by clauses,
+//! too. The function returns false if the problem is unsatisfiable.
+[[nodiscard]] bool substitute_equivalences(Clingo::PropagateInit &init, XORStore &iqs, EquivalenceClasses &classes, PreprocessingStatistics &stats);
+
+//! Merge and eliminate XOR constraints whose literal is true on level 0.
+//!
+//! Two such constraints sharing many variables are replaced by one of them
+//! and their sum if the sum is shorter. Then, constraints containing an
+//! auxiliary variable that occurs in no other constraint are moved from the
+//! store to the given store of eliminated constraints. Eliminated
+//! constraints are not propagated but only checked on total assignments.
+void eliminate_variables(Clingo::PropagateInit &init, XORStore &iqs, XORStore &eliminated, PreprocessingStatistics &stats);
@@ -3,10 +3,210 @@
 #include <clingo.hh>
 #include "util.hh"
 
+//! An XOR constraint referring to the storage of an XORStore.
+//!
+//! The constraint is only valid as long as the store is not modified.
 struct XORConstraint {
-    std::vector<index_t> lhs;
+    Clingo::Span<index_t> lhs;
     Value rhs;
     Clingo::literal_t lit;
 };
 
 std::ostream &operator<<(std::ostream &out, XORConstraint const &x);
+
+//! The engine used to solve XOR constraints.
+enum class Engine {
+    //! Simplex-based solver with lazy conflict detection.
+    Simplex,
+    //! Gauss-Jordan elimination with watched columns.
+    //!
+    //! The simplex-based solver is used instead if the dense matrix would
+    //! exceed 128 MiB per thread.
+    GaussJordan
+};
+
+//! The configuration of the propagator.
+struct Config {
+    //! The engine used to solve XOR constraints.
+    Engine engine{Engine::Simplex};
+    //! The number of threads used to evaluate theory atoms (0 to use one
+    //! thread per core, 1 to evaluate them sequentially).
+    size_t parse_threads{0};
+    //! Whether propagation is enabled.
+    bool propagate{true};
+    //! Whether to defer solving on decision levels greater than 0 to the
+    //! check callback.
+    bool check_only{false};
+    //! In check-only mode, also check partial assignments on decision
+    //! levels divisible by this number (0 to check total assignments only).
+    size_t check_interval{0};
+    //! Whether to take the polarity of decisions on XOR variables from the
+    //! assignment of the solver.
+    bool phase{false};
+    //! Whether to decide on variables involved in many XOR conflicts first.
+    bool activity{false};
+    //! Whether to derive equivalences from rows with two unassigned
+    //! variables during propagation.
+    bool propagate_binary{false};
+    //! Whether to select the shortest conflict clause among the conflicting
+    //! rows.
+    bool shortest_conflict{false};
+    //! Whether to substitute equivalences from binary XOR constraints.
+    bool equivalences{true};
+    //! Whether to merge XOR constraints and eliminate auxiliary variables
+    //! occurring in only one XOR constraint.
+    bool eliminate{false};
+    //! Whether to use a dense tableau for problems with at most 512
+    //! variables.
+    bool dense{true};
+    //! Handle constraints with at most this many variables with a watched
+    //! solver instead of the selected engine (0 to disable).
+    size_t watched_length{0};
+    //! Translate constraints with at most this many literals into clauses
+    //! (at most 20 because the translation is exponential).
+    size_t translate{0};
+    //! Cut constraints with more than this many literals into chains of
+    //! constraints using auxiliary literals (0 to disable, otherwise at
+    //! least 3).
+    size_t cut{0};
+    //! The type of conflict and reason clauses added by the engines.
+    Clingo::ClauseType clause_type{Clingo::ClauseType::Learnt};
+    //! Do not add reasons with more than this many literals (0 for no
+    //! limit).
+    size_t reason_length{0};
+    //! The maximum number of pivots per call to the simplex-based solver (0
+    //! for no limit).
+    size_t pivot_budget{0};
+    //! Refactor the tableau if its size exceeds the initial size by this
+    //! factor (0 to only refactor on level 0).
+    double refactor{0};
+    //! Revert the pivots of a decision level when backtracking if the
+    //! tableau grew by this factor on the level (0 to never revert).
+    double revert{0};
+};
+
+//! A compact store for XOR constraints.
+//!
+//! The left-hand sides of all constraints are stored consecutively in one
+//! array (compressed sparse row format) to avoid one allocation per
+//! constraint.
+//!
+//! Furthermore, the store associates a literal with each variable. The
+//! variable is true if and only if the literal is true. These bounds are not
+//! stored as constraints.
+class XORStore {
+public:
+    //! Add a variable associated with the given literal.
+    //!
+    //! Auxiliary variables are introduced by the propagator and occur in no
+    //! clause or rule of the program.
+    index_t add_variable(Clingo::literal_t lit, bool auxiliary = false) {
+        var_lits_.emplace_back(lit);
+        auxiliary_.emplace_back(auxiliary);
+        return static_cast<index_t>(var_lits_.size() - 1);
+    }
+
+    //! Check whether the given variable is auxiliary.
+    [[nodiscard]] bool auxiliary(index_t var) const {
+        assert(var < n_variables());
+        return auxiliary_[var];
+    }
+
+    //! Mark the given variable as occurring outside of the store.
+    void unset_auxiliary(index_t var) {
+        assert(var < n_variables());
+        auxiliary_[var] = false;
+    }
+
+    //! Get the literal associated with the given variable.
+    [[nodiscard]] Clingo::literal_t variable(index_t var) const {
+        assert(var < n_variables());
+        return var_lits_[var];
+    }
+
+    //! Get the number of variables.
+    [[nodiscard]] size_t n_variables() const {
+        return var_lits_.size();
+    }
+
+    //! Add a constraint to the store.
+    template <class It>
+    void add(It begin, It end, Value rhs, Clingo::literal_t lit) {
+        indices_.insert(indices_.end(), begin, end);
+        offsets_.emplace_back(indices_.size());
+        rhs_.emplace_back(static_cast<bool>(rhs));
+        lits_.emplace_back(lit);
+    }
+
+    //! Get the constraint at the given index.
+    [[nodiscard]] XORConstraint operator[](size_t i) const {
+        assert(i < size());
+        return {Clingo::Span<index_t>{indices_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]}, // NOLINT
+                Value{rhs_[i]},
+                lits_[i]};
+    }
+
+    //! Get the number of constraints in the store.
+    [[nodiscard]] size_t size() const {
+        return lits_.size();
+    }
+
+    //! Get the total number of variable occurrences in the store.
+    [[nodiscard]] size_t n_elements() const {
+        return indices_.size();
+    }
+
+    //! Rewrite the constraints in the store.
+    //!
+    //! Function `f(lhs, rhs, lit)` is called for each constraint with a
+    //! vector holding its left-hand side. The function can modify the
+    //! left-hand side and the right-hand side but must not add elements to
+    //! the left-hand side. The constraint is removed if the function returns
+    //! false.
+    template <class F>
+    void rewrite(F &&f) {
+        std::vector<index_t> lhs;
+        size_t n = 0;
+        index_t begin = 0;
+        for (size_t k = 0, e = size(); k != e; ++k) {
+            index_t end = offsets_[k + 1];
+            lhs.assign(indices_.begin() + begin, indices_.begin() + end);
+            begin = end;
+            Value rhs{rhs_[k]};
+            auto lit = lits_[k];
+            if (!f(lhs, rhs, lit)) {
+                continue;
+            }
+            // Note: Because left-hand sides do not grow, this never
+            // overwrites constraints that have not been visited yet.
+            assert(offsets_[n] + lhs.size() <= end);
+            std::copy(lhs.begin(), lhs.end(), indices_.begin() + offsets_[n]);
+            offsets_[n + 1] = offsets_[n] + lhs.size();
+            rhs_[n] = static_cast<bool>(rhs);
+            lits_[n] = lit;
+            ++n;
+        }
+        indices_.resize(offsets_[n]);
+        offsets_.resize(n + 1);
+        rhs_.resize(n);
+        lits_.resize(n);
+    }
+
+    //! Release memory not needed for the currently stored constraints.
+    void shrink_to_fit() {
+        offsets_.shrink_to_fit();
+        indices_.shrink_to_fit();
+        rhs_.shrink_to_fit();
+        lits_.shrink_to_fit();
+        var_lits_.shrink_to_fit();
+        auxiliary_.shrink_to_fit();
+    }
+
+private:
+    std::vector<index_t> offsets_{0};
+    std::vector<index_t> indices_;
+    std::vector<bool> rhs_;
+    std::vector<Clingo::literal_t> lits_;
+    std::vector<Clingo::literal_t> var_lits_;
+    std::vector<bool> auxiliary_;
+};
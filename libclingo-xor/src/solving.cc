@@ -1,78 +1,197 @@
 #include "solving.hh"
 #include "parsing.hh"
+#include "preprocessing.hh"
+#include "gauss.hh"
 
 #include <unordered_set>
 
-bool Solver::Variable::update_bound(Solver &s, Clingo::Assignment ass, Bound const &bound) {
-    if (!has_bound()) {
-        s.bound_trail_.emplace_back(bound.variable);
-        this->bound = &bound;
+void Statistics::reset() {
+    *this = {};
+}
+
+void Statistics::add_conflict(size_t length) {
+    size_t b = 0;
+    while (b + 1 < conflict_buckets && (size_t{1} << b) < length) {
+        ++b;
     }
-    return this->bound->value == bound.value;
+    ++conflict_lengths[b];
 }
 
-void Solver::Variable::flip_value(Solver &s, index_t lvl) {
-    // We can always assume that the assignment on a previous level was satisfying.
-    // Thus, we simply store the old values to be able to restore them when backtracking.
-    if (lvl != level) {
-        // This assumes that the variable is contained in the variables_ vector
-        // of the solver.
-        s.assignment_trail_.emplace_back(level, this - s.variables_.data(), value);
-        level = lvl;
+void ConflictActivity::init(XORStore const &iqs) {
+    auto n = static_cast<index_t>(iqs.n_variables());
+    heap_.resize(n);
+    lits_.clear();
+    vars_.clear();
+    removed_.clear();
+    for (index_t i = 0; i != n; ++i) {
+        auto lit = iqs.variable(i);
+        lits_.emplace_back(lit);
+        vars_.emplace(lit, i);
+        vars_.emplace(-lit, i);
+        heap_.push(i);
     }
-    value.flip();
 }
 
-bool Solver::Variable::has_conflict() const {
-    return has_bound() && value != bound->value;
+void ConflictActivity::bump(Clingo::LiteralSpan clause) {
+    for (auto lit : clause) {
+        auto it = vars_.find(lit);
+        if (it != vars_.end()) {
+            heap_.bump(it->second);
+        }
+    }
+    heap_.decay();
 }
 
-void Statistics::reset() {
-    *this = {};
+void ConflictActivity::restore() {
+    for (auto i : removed_) {
+        heap_.push(i);
+    }
+    removed_.clear();
+}
+
+bool add_clause(Clingo::PropagateControl &ctl, Clingo::LiteralSpan clause, Clingo::ClauseType type, size_t reason_length, bool conflict, Statistics &stats) {
+    if (!conflict && reason_length > 0 && clause.size() > reason_length) {
+        ++stats.skipped_reasons;
+        return true;
+    }
+    ++stats.clauses[static_cast<size_t>(type)];
+    return ctl.add_clause(clause, type);
 }
 
-Solver::Solver(std::vector<XORConstraint> const &inequalities, bool enable_propagate)
+template <bool Propagate, typename Index, typename Matrix>
+Solver<Propagate, Index, Matrix>::Solver(XORStore const &inequalities, Config const &config)
 : inequalities_{inequalities}
-, enable_propagate_{enable_propagate}
+, refactor_factor_{config.refactor}
+, revert_factor_{config.revert}
+, propagate_binary_enabled_{config.propagate_binary}
+, shortest_conflict_{config.shortest_conflict}
+, clause_type_{config.clause_type}
+, reason_length_{config.reason_length}
+, pivot_budget_{config.pivot_budget}
+, activity_enabled_{config.activity}
 { }
 
-Solver::Variable &Solver::basic_(index_t i) {
+template <bool Propagate, typename Index, typename Matrix>
+index_t Solver<Propagate, Index, Matrix>::basic_(index_t i) const {
     assert(i < n_basic_);
-    return variables_[variables_[i + n_non_basic_].index];
+    return index_[i + n_non_basic_];
 }
 
-Solver::Variable &Solver::non_basic_(index_t j) {
+template <bool Propagate, typename Index, typename Matrix>
+index_t Solver<Propagate, Index, Matrix>::non_basic_(index_t j) const {
     assert(j < n_non_basic_);
-    return variables_[variables_[j].index];
+    return index_[j];
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::has_bound_(index_t x) const {
+    return bound_[x] != no_bound;
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+auto Solver<Propagate, Index, Matrix>::bound_of_(index_t x) const -> Bound const & {
+    assert(has_bound_(x));
+    return bounds_[bound_[x]];
 }
 
-void Solver::enqueue_(index_t i) {
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::has_conflict_(index_t x) const {
+    return conflicting_(reverse_index_[x]);
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::conflicting_(index_t k) const {
+    return bounded_.test(k) && values_.test(k) != bound_values_.test(k);
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+index_t Solver<Propagate, Index, Matrix>::find_conflicting_(index_t begin, index_t end) const {
+    return BitSet::find_first(begin, end, [&](size_t k) {
+        return (values_.word(k) ^ bound_values_.word(k)) & bounded_.word(k);
+    });
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::update_bound_(index_t x, index_t bound) {
+    if (!has_bound_(x)) {
+        bound_trail_.emplace_back(x);
+        bound_[x] = bound;
+        bounded_.set(reverse_index_[x]);
+        bound_values_.assign(reverse_index_[x], static_cast<bool>(bounds_[bound].value));
+    }
+    return bound_of_(x).value == bounds_[bound].value;
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::flip_value_(index_t lvl, index_t k) {
+    // We can always assume that the assignment on a previous level was satisfying.
+    // Thus, we simply store the old values to be able to restore them when backtracking.
+    auto x = index_[k];
+    if (lvl != level_[x]) {
+        assignment_trail_.emplace_back(level_[x], x, Value{values_.test(k)});
+        level_[x] = lvl;
+    }
+    values_.flip(k);
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::enqueue_(index_t i) {
     assert(i < n_basic_);
-    auto ii = variables_[i + n_non_basic_].index;
-    auto &xi = variables_[ii];
-    if (!xi.queued && xi.has_conflict()) {
-        conflicts_.emplace(ii);
-        xi.queued = true;
+    auto ii = basic_(i);
+    if (!queued_.test(ii) && conflicting_(i + n_non_basic_)) {
+        conflicts_.emplace_back(ii);
+        std::push_heap(conflicts_.begin(), conflicts_.end(), std::greater<>{});
+        queued_.set(ii);
     }
 }
 
-Value Solver::get_value(index_t i) const {
-    return variables_[i].value;
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::pop_conflict_() {
+    std::pop_heap(conflicts_.begin(), conflicts_.end(), std::greater<>{});
+    conflicts_.pop_back();
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+Value Solver<Propagate, Index, Matrix>::get_value(index_t i) const {
+    return Value{values_.test(reverse_index_[i])};
 }
 
-bool Solver::prepare(Clingo::PropagateInit &init, size_t n_variables) {
+template <bool Propagate, typename Index, typename Matrix>
+Clingo::literal_t Solver<Propagate, Index, Matrix>::decide(Clingo::Assignment const &ass) {
+    if (!activity_enabled_) {
+        return 0;
+    }
+    return activity_.decide(ass, [&](index_t i) { return values_.test(reverse_index_[i]); });
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::prepare(Clingo::PropagateInit &init) {
     auto ass = init.assignment();
 
-    // initialize non-basic variables
-    variables_.resize(n_variables);
-    n_non_basic_ = n_variables;
-    for (index_t i = 0; i != n_non_basic_; ++i) {
-        variables_[i].index = i;
-        variables_[i].reverse_index = i;
+    auto add_bound = [&](index_t x, Clingo::literal_t lit, Value value) {
+        lit_bounds_.emplace(lit, bounds_.size());
+        bounds_.emplace_back(Bound{value, x, lit});
+    };
+
+    // initialize non-basic variables and their bounds
+    auto n_variables = static_cast<index_t>(inequalities_.n_variables());
+    bound_offsets_.reserve(n_variables + inequalities_.size() + 1);
+    bound_offsets_.emplace_back(0);
+    for (index_t j = 0; j != n_variables; ++j) {
+        auto lit = inequalities_.variable(j);
+        if (!ass.is_false(-lit)) {
+            add_bound(j, -lit, Value{false});
+        }
+        if (!ass.is_false(lit)) {
+            add_bound(j, lit, Value{true});
+        }
+        bound_offsets_.emplace_back(bounds_.size());
     }
+    n_non_basic_ = n_variables;
 
     // setup tableaux, bounds, and basic variables
-    for (auto const &x : inequalities_) {
+    for (size_t k = 0, e = inequalities_.size(); k != e; ++k) {
+        auto x = inequalities_[k];
         if (ass.is_false(x.lit)) {
             continue;
         }
@@ -83,30 +202,13 @@ bool Solver::prepare(Clingo::PropagateInit &init, size_t n_variables) {
                 return false;
             }
         }
-        // add a bound to a non-basic variable
-        else if (x.lhs.size() == 1) {
-            auto j = x.lhs.front();
-            auto it = bounds_.emplace(x.lit, Bound{
-                Value{x.rhs},
-                variables_[j].index,
-                x.lit});
-            variables_[j].bounds.emplace_back(&it->second);
-        }
         // add an xor constraint
-        // (guaranteed to have at least two elements)
         else {
-            // add basic variable
-            auto index = variables_.size();
-            variables_.emplace_back();
-            variables_.back().index = index;
-            variables_.back().reverse_index = index;
+            // add basic variable with its bound
             auto i = n_basic_++;
-            // add bound
-            auto it = bounds_.emplace(x.lit, Bound{
-                Value{x.rhs},
-                static_cast<index_t>(variables_.size() - 1),
-                x.lit});
-            variables_.back().bounds.emplace_back(&it->second);
+            row_inequalities_.emplace_back(k);
+            add_bound(n_non_basic_ + i, x.lit, x.rhs);
+            bound_offsets_.emplace_back(bounds_.size());
             // set tableaux
             for (auto j : x.lhs) {
                 tableau_.set(i, j, true);
@@ -114,10 +216,36 @@ bool Solver::prepare(Clingo::PropagateInit &init, size_t n_variables) {
         }
     }
 
-    for (size_t i = 0; i < n_basic_; ++i) {
+    // initialize variable arrays
+    auto n = n_non_basic_ + n_basic_;
+    index_.resize(n);
+    reverse_index_.resize(n);
+    for (index_t x = 0; x != n; ++x) {
+        index_[x] = x;
+        reverse_index_[x] = x;
+    }
+    level_.resize(n, 0);
+    bound_.resize(n, no_bound);
+    values_.resize(n);
+    bounded_.resize(n);
+    bound_values_.resize(n);
+    queued_.resize(n);
+    in_propagate_set_.resize(n_basic_);
+    in_batch_.resize(n_non_basic_);
+    candidates_.resize(n_basic_);
+    binary_hashes_.resize(n_basic_);
+    constants_.resize(n_basic_);
+    fixed_.resize(n);
+    free_.resize(n);
+
+    for (index_t i = 0; i < n_basic_; ++i) {
         enqueue_(i);
     }
 
+    if (activity_enabled_) {
+        activity_.init(inequalities_);
+    }
+
     assert_extra(check_tableau_());
     assert_extra(check_basic_());
     assert_extra(check_non_basic_());
@@ -128,42 +256,67 @@ bool Solver::prepare(Clingo::PropagateInit &init, size_t n_variables) {
     statistics_.tableau_initial = tableau_.size();
     statistics_.tableau_average = tableau_.size();
     statistics_.tableau_average_n = 1;
+    tableau_base_ = tableau_.size();
 
     return true;
 }
 
-bool Solver::propagate_(Clingo::PropagateControl &ctl) {
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::propagate_(Clingo::PropagateControl &ctl) {
     auto timer = statistics_.propagate.start();
     bool ret = true;
 
+    size_t max_free = propagate_binary_enabled_ ? 2 : 1;
     for (auto i : propagate_set_) {
         conflict_clause_.clear();
         size_t num_free = 0;
-        Variable *free = nullptr;
+        std::array<index_t, 2> frees{0, 0};
         tableau_.update_row(i, [&](index_t j) {
-            auto &xj = non_basic_(j);
-            if (!xj.has_bound()) {
+            if (!bounded_.test(j)) {
+                if (num_free < frees.size()) {
+                    frees[num_free] = non_basic_(j);
+                }
                 num_free += 1;
-                free = &xj;
             }
             else {
-                conflict_clause_.emplace_back(-xj.bound->lit);
+                conflict_clause_.emplace_back(-bound_of_(non_basic_(j)).lit);
             }
-            return num_free <= 1;
+            return num_free <= max_free;
         });
-        auto &xi = basic_(i);
-        if (!xi.has_bound()) {
+        auto xi = basic_(i);
+        if (!has_bound_(xi)) {
+            if (num_free < frees.size()) {
+                frees[num_free] = xi;
+            }
             num_free += 1;
-            free = &xi;
         }
         else {
-            conflict_clause_.emplace_back(-xi.bound->lit);
+            conflict_clause_.emplace_back(-bound_of_(xi).lit);
+        }
+        if (num_free == 2 && propagate_binary_enabled_) {
+            if (!propagate_binary_(ctl, i, frees[0], frees[1])) {
+                ret = false;
+                break;
+            }
         }
-        if (num_free == 1) {
+        else if (num_free == 1) {
+            auto free = frees[0];
             size_t num = 0;
             bool sat = false;
-            for (auto *bound : free->bounds) {
-                auto lit = free->value == bound->value ? bound->lit : -bound->lit;
+            Value value{values_.test(reverse_index_[free])};
+            auto ib = bound_offsets_[free];
+            auto ie = bound_offsets_[free + 1];
+            for (auto it = ib; it != ie; ++it) {
+                auto const &bound = bounds_[it];
+                // Note: A variable with a single bound belongs to an XOR
+                // constraint, which only has to hold if its literal is true.
+                // Hence, nothing can be derived if the value of the variable
+                // satisfies the bound.
+                if (ie - ib == 1 && value == bound.value) {
+                    sat = true;
+                    break;
+                }
+                auto lit = value == bound.value ? bound.lit : -bound.lit;
                 // Note: This case can happen if a bound is propagated but the
                 // propagator has not yet been notified about the change.
                 if (ctl.assignment().is_true(lit)) {
@@ -179,7 +332,7 @@ bool Solver::propagate_(Clingo::PropagateControl &ctl) {
             // Note: By construction, a variable has at most two bounds. In
             // case it has two bounds, they have opposite literals and values.
             // Thus, the conflict_clause_ is guaranteed to be unit-resulting.
-            if (!sat && !ctl.add_clause(conflict_clause_)) {
+            if (!sat && !add_clause(ctl, conflict_clause_, clause_type_, reason_length_, false, statistics_)) {
                 ret = false;
                 break;
             }
@@ -189,67 +342,181 @@ bool Solver::propagate_(Clingo::PropagateControl &ctl) {
     return ret;
 }
 
-bool Solver::solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits) {
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::propagate_binary_(Clingo::PropagateControl &ctl, index_t i, index_t x, index_t y) {
+    // Note: Slack variables only have to satisfy their bound if the literal
+    // of the associated constraint is true. No equivalence can be derived
+    // for them.
+    if (x >= n_non_basic_ || y >= n_non_basic_) {
+        return true;
+    }
+    // Note: All other variables in the row are at their bounds. Since the
+    // current assignment satisfies the row, the sum of x and y is the same
+    // in every assignment satisfying the row and the bounds.
+    auto lx = inequalities_.variable(x);
+    auto ly = inequalities_.variable(y);
+    if (values_.test(reverse_index_[x]) != values_.test(reverse_index_[y])) {
+        ly = -ly;
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto lit : conflict_clause_) {
+        hash = (hash ^ static_cast<uint32_t>(lit)) * 1099511628211ULL;
+    }
+    hash = (hash ^ static_cast<uint32_t>(lx)) * 1099511628211ULL;
+    hash = (hash ^ static_cast<uint32_t>(ly)) * 1099511628211ULL;
+    auto ass = ctl.assignment();
+    auto level = ass.decision_level();
+    auto &last = binary_hashes_[i];
+    if (last.hash == hash && (clause_type_ == Clingo::ClauseType::Static ||
+                              (last.level <= level && ass.decision(last.level) == last.decision))) {
+        return true;
+    }
+
+    ++statistics_.equivalences;
+    auto n = conflict_clause_.size();
+    conflict_clause_.emplace_back(-lx);
+    conflict_clause_.emplace_back(ly);
+    if (!add_clause(ctl, conflict_clause_, clause_type_, reason_length_, false, statistics_)) {
+        return false;
+    }
+    conflict_clause_[n] = lx;
+    conflict_clause_[n + 1] = -ly;
+    if (!add_clause(ctl, conflict_clause_, clause_type_, reason_length_, false, statistics_)) {
+        return false;
+    }
+    // Note: If the reason length skipped the clauses, nothing is recorded so
+    // that the equivalence is derived again the next time the row is
+    // propagated.
+    if (reason_length_ == 0 || conflict_clause_.size() <= reason_length_) {
+        last = {hash, level, ass.decision(level)};
+    }
+    return true;
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits) {
     auto timer = statistics_.total.start();
-    index_t i{0};
-    index_t j{0};
 
     auto ass = ctl.assignment();
     auto level = ass.decision_level();
 
+    // Note: Levels that have been backtracked without a call to undo are
+    // undone here. Further calls on the same level share its trail offset.
+    if (!trail_offset_.empty() && trail_offset_.back().level > level) {
+        undo(level + 1);
+    }
+    bool incomplete = !trail_offset_.empty() && trail_offset_.back().incomplete;
     if (trail_offset_.empty() || trail_offset_.back().level < level) {
         trail_offset_.emplace_back(TrailOffset{
             ass.decision_level(),
             static_cast<index_t>(bound_trail_.size()),
-            static_cast<index_t>(assignment_trail_.size())});
+            static_cast<index_t>(assignment_trail_.size()),
+            static_cast<index_t>(pivot_trail_.size()),
+            tableau_.size(),
+            incomplete});
     }
 
     // NOTE: Initially, all rows in the tableaux are guaranteed to have at
     // least two elements. This means that initially there are no rows that can
     // be propagated because at least one bound has to be set. If any row
     // becomes unit-resulting, it is enqueued below and propagated at the end
-    // in case the XOR constraints are found to be satisfiable.
-    for (auto i : propagate_set_) {
-        variables_[i].in_propagate_set = false;
+    // in case the XOR constraints are found to be satisfiable. Rows marked
+    // during calls that ran out of pivots are kept.
+    if (!incomplete) {
+        for (auto i : propagate_set_) {
+            in_propagate_set_.reset(i);
+        }
+        propagate_set_.clear();
     }
-    propagate_set_.clear();
 
     for (auto lit : lits) {
-        for (auto it = bounds_.find(lit), ie = bounds_.end(); it != ie && it->first == lit; ++it) {
-            auto const &[lit, bound] = *it;
-            auto &x = variables_[bound.variable];
-            if (!x.update_bound(*this, ctl.assignment(), bound)) {
+        for (auto it = lit_bounds_.find(lit), ie = lit_bounds_.end(); it != ie && it->first == lit; ++it) {
+            auto const &bound = bounds_[it->second];
+            auto x = bound.variable;
+            if (!update_bound_(x, it->second)) {
                 conflict_clause_.clear();
                 conflict_clause_.emplace_back(-bound.lit);
-                conflict_clause_.emplace_back(-x.bound->lit);
-                ctl.add_clause(conflict_clause_);
+                conflict_clause_.emplace_back(-bound_of_(x).lit);
+                statistics_.add_conflict(conflict_clause_.size());
+                if (activity_enabled_) {
+                    activity_.bump(conflict_clause_);
+                }
+                for (auto j : batch_columns_) {
+                    in_batch_.reset(j);
+                }
+                batch_columns_.clear();
+                batch_rows_.clear();
+                add_clause(ctl, conflict_clause_, clause_type_, reason_length_, true, statistics_);
                 return false;
             }
-            if (x.reverse_index < n_non_basic_) {
-                // NOTE: The way rows are marked for propagation here is
-                // probably not as efficient as it could be.
-                if (x.has_bound() && x.value != x.bound->value) {
-                    update_(level, x.reverse_index);
-                }
-                else {
-                    propagate_col_(x.reverse_index);
+            if (reverse_index_[x] < n_non_basic_) {
+                auto j = reverse_index_[x];
+                if (!in_batch_.test(j)) {
+                    in_batch_.set(j);
+                    batch_columns_.emplace_back(j);
                 }
             }
             else {
-                auto i = x.reverse_index - n_non_basic_;
-                enqueue_(i);
-                propagate_row_(i);
+                batch_rows_.emplace_back(reverse_index_[x] - n_non_basic_);
             }
         }
     }
 
+    // Note: Columns are only traversed once even if several literals bound
+    // the same variable. Rows are enqueued afterward so that they are
+    // checked against the values after updating the columns.
+    for (auto j : batch_columns_) {
+        in_batch_.reset(j);
+        if (has_conflict_(non_basic_(j))) {
+            update_(level, j);
+        }
+        else {
+            propagate_col_(j);
+        }
+    }
+    batch_columns_.clear();
+    for (auto i : batch_rows_) {
+        enqueue_(i);
+        propagate_row_(i);
+    }
+    batch_rows_.clear();
+
     assert_extra(check_tableau_());
     assert_extra(check_basic_());
     assert_extra(check_non_basic_());
 
+    return pivot_loop_(ctl, level, pivot_budget_);
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::finish(Clingo::PropagateControl &ctl) {
+    auto level = ctl.assignment().decision_level();
+    if (!trail_offset_.empty() && trail_offset_.back().level > level) {
+        undo(level + 1);
+    }
+    if (trail_offset_.empty() || !trail_offset_.back().incomplete) {
+        return true;
+    }
+    auto timer = statistics_.total.start();
+    // Note: The solver might not have been called on the current level.
+    // Values are recorded for the last level it has been called on so that
+    // they are restored when this level is undone.
+    return pivot_loop_(ctl, trail_offset_.back().level, 0);
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::pivot_loop_(Clingo::PropagateControl &ctl, index_t level, size_t budget) {
+    index_t i{0};
+    index_t j{0};
+    auto ass = ctl.assignment();
+    auto &offset = trail_offset_.back();
+    size_t pivots = 0;
+
     while (true) {
         switch (select_(i, j)) {
             case State::Satisfiable: {
+                offset.incomplete = false;
                 // Note: This hopefully is not too expensive to compute.
                 // Otherwise, size could also be maintained by the tableaux to
                 // make this constant.
@@ -258,127 +525,183 @@ bool Solver::solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits) {
                 double a = (n - 1) / n;
                 statistics_.tableau_average *= a;
                 statistics_.tableau_average += tableau_.size() / n;
-                return propagate_(ctl);
+                if (!propagate_(ctl)) {
+                    return false;
+                }
+                if (needs_refactor_(ass.decision_level())) {
+                    refactor_();
+                }
+                if (ass.decision_level() == 0) {
+                    simplify_(ass);
+                }
+                return true;
             }
             case State::Unsatisfiable: {
-                ctl.add_clause(conflict_clause_);
+                add_clause(ctl, conflict_clause_, clause_type_, reason_length_, true, statistics_);
                 return false;
             }
             case State::Unknown: {
+                // Note: The remaining conflicting variables stay in the
+                // queue and pivoting continues on the next call.
+                if (budget > 0 && pivots == budget) {
+                    enqueue_(i);
+                    offset.incomplete = true;
+                    ++statistics_.exhausted;
+                    return true;
+                }
+                ++pivots;
                 pivot_(level, i, j);
             }
         }
     }
 }
 
-void Solver::undo() {
-    // this function restores the last satisfying assignment
-    auto &offset = trail_offset_.back();
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::undo(index_t level) {
+    // this function restores the last satisfying assignment before the
+    // given level
+    if (activity_enabled_) {
+        activity_.restore();
+    }
+    if (trail_offset_.empty() || trail_offset_.back().level < level) {
+        return;
+    }
+    auto it_offset = trail_offset_.end();
+    while (it_offset != trail_offset_.begin() && std::prev(it_offset)->level >= level) {
+        --it_offset;
+    }
+    auto &offset = *it_offset;
+
+    // removing bounds makes variables flippable again
+    ++epoch_;
 
     // undo bound updates
     for (auto it = bound_trail_.begin() + offset.bound, ie = bound_trail_.end(); it != ie; ++it) {
-        variables_[*it].bound = nullptr;
+        bound_[*it] = no_bound;
+        bounded_.reset(reverse_index_[*it]);
     }
     bound_trail_.resize(offset.bound);
 
     // undo assignments
-    for (auto it = assignment_trail_.begin() + offset.assignment, ie = assignment_trail_.end(); it != ie; ++it) {
+    //
+    // A variable is recorded at most once per level. The trail is traversed
+    // backwards so that the oldest value is restored when undoing multiple
+    // levels.
+    for (auto it = assignment_trail_.rbegin(), ie = assignment_trail_.rend() - offset.assignment; it != ie; ++it) {
         auto &[level, index, number] = *it;
-        variables_[index].level = level;
-        variables_[index].value = number;
+        level_[index] = level;
+        values_.assign(reverse_index_[index], static_cast<bool>(number));
     }
     assignment_trail_.resize(offset.assignment);
 
     // empty queue
-    for (; !conflicts_.empty(); conflicts_.pop()) {
-        variables_[conflicts_.top()].queued = false;
+    for (auto ii : conflicts_) {
+        queued_.reset(ii);
+    }
+    conflicts_.clear();
+
+    for (auto it = trail_offset_.end(); it != it_offset; --it) {
+        revert_(*std::prev(it));
     }
 
-    trail_offset_.pop_back();
+    trail_offset_.erase(it_offset, trail_offset_.end());
+
+    // Note: If the restored assignment stems from a call that ran out of
+    // pivots, non-basic variables might violate their bounds after
+    // pivoting. They are fixed and all conflicting rows are enqueued again.
+    if (!trail_offset_.empty() && trail_offset_.back().incomplete) {
+        auto level = trail_offset_.back().level;
+        for (index_t j = 0; j != n_non_basic_; ++j) {
+            if (has_conflict_(non_basic_(j))) {
+                update_(level, j);
+            }
+        }
+        for (index_t i = 0; i != n_basic_; ++i) {
+            enqueue_(i);
+        }
+        return;
+    }
 
     assert_extra(check_solution_());
 }
 
-Statistics const &Solver::statistics() const {
+template <bool Propagate, typename Index, typename Matrix>
+Statistics const &Solver<Propagate, Index, Matrix>::statistics() const {
     return statistics_;
 }
 
-bool Solver::check_tableau_() {
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::check_tableau_() {
     for (index_t i{0}; i < n_basic_; ++i) {
-        Value v_i;
+        bool v_i = constants_.test(i);
         tableau_.update_row(i, [&](index_t j){
-            v_i ^= non_basic_(j).value;
+            v_i ^= values_.test(j);
             return true;
         });
-        if (v_i != basic_(i).value) {
+        if (v_i != values_.test(i + n_non_basic_)) {
             return false;
         }
     }
     return true;
 }
 
-bool Solver::check_basic_() {
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::check_basic_() {
     for (index_t i = 0; i < n_basic_; ++i) {
-        auto &xi = basic_(i);
-        if (xi.has_bound() && xi.value != xi.bound->value && !xi.queued) {
+        auto xi = basic_(i);
+        if (has_conflict_(xi) && !queued_.test(xi)) {
             return false;
         }
     }
     return true;
 }
 
-bool Solver::check_non_basic_() {
-    for (index_t j = 0; j < n_non_basic_; ++j) {
-        auto &xj = non_basic_(j);
-        if (xj.has_bound() && xj.value != xj.bound->value) {
-            return false;
-        }
-    }
-    return true;
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::check_non_basic_() {
+    return find_conflicting_(0, n_non_basic_) == n_non_basic_;
 }
 
-bool Solver::check_solution_() {
-    for (auto &x : variables_) {
-        if (x.has_bound() && x.bound->value != x.value) {
-            return false;
-        }
-    }
-    return check_tableau_() && check_basic_();
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::check_solution_() {
+    auto n = static_cast<index_t>(index_.size());
+    return find_conflicting_(0, n) == n && check_tableau_() && check_basic_();
 }
 
-void Solver::propagate_row_(index_t i) {
-    if (enable_propagate_ && !variables_[i].in_propagate_set) {
-        propagate_set_.emplace_back(i);
-        variables_[i].in_propagate_set = true;
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::propagate_row_(index_t i) {
+    if constexpr (Propagate) {
+        if (!in_propagate_set_.test(i)) {
+            propagate_set_.emplace_back(i);
+            in_propagate_set_.set(i);
+        }
     }
 }
 
-void Solver::propagate_col_(index_t j) {
-    if (enable_propagate_) {
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::propagate_col_(index_t j) {
+    if constexpr (Propagate) {
         tableau_.update_col(j, [&](index_t i) { propagate_row_(i); });
     }
 }
 
-void Solver::update_(index_t level, index_t j) {
-    auto &xj = non_basic_(j);
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::update_(index_t level, index_t j) {
     tableau_.update_col(j, [&](index_t i) {
-        basic_(i).flip_value(*this, level);
+        flip_value_(level, i + n_non_basic_);
         enqueue_(i);
         propagate_row_(i);
     });
-    xj.flip_value(*this, level);
+    flip_value_(level, j);
 }
 
-void Solver::pivot_(index_t level, index_t i, index_t j) {
-    auto &xi = basic_(i);
-    auto &xj = non_basic_(j);
-
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::pivot_(index_t level, index_t i, index_t j) {
     // adjust assignment
-    xi.flip_value(*this, level);
-    xj.flip_value(*this, level);
+    flip_value_(level, i + n_non_basic_);
+    flip_value_(level, j);
     tableau_.update_col(j, [&](index_t k) {
         if (k != i) {
-            basic_(k).flip_value(*this, level);
+            flip_value_(level, k + n_non_basic_);
             enqueue_(k);
             propagate_row_(k);
         }
@@ -386,13 +709,11 @@ void Solver::pivot_(index_t level, index_t i, index_t j) {
     assert_extra(check_tableau_());
 
     // swap variables x_i and x_j
-    std::swap(xi.reverse_index, xj.reverse_index);
-    std::swap(variables_[i + n_non_basic_].index, variables_[j].index);
+    swap_basis_(i, j);
     enqueue_(i);
-
-    // eliminate x_j from rows k != i
-    // Propagation: this operation changes the number of free variables in a row
-    tableau_.eliminate(i, j);
+    if (revert_factor_ > 0 && level > 0) {
+        pivot_trail_.emplace_back(i, j);
+    }
 
     ++statistics_.pivots;
     assert_extra(check_tableau_());
@@ -400,49 +721,93 @@ void Solver::pivot_(index_t level, index_t i, index_t j) {
     assert_extra(check_non_basic_());
 }
 
-bool Solver::flippable_(Variable const &x) {
-    if (!x.has_bound() || x.value != x.bound->value) {
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::swap_basis_(index_t i, index_t j) {
+    auto xi = basic_(i);
+    auto xj = non_basic_(j);
+    std::swap(reverse_index_[xi], reverse_index_[xj]);
+    std::swap(index_[i + n_non_basic_], index_[j]);
+    values_.swap(i + n_non_basic_, j);
+    bounded_.swap(i + n_non_basic_, j);
+    bound_values_.swap(i + n_non_basic_, j);
+
+    // eliminate x_j from rows k != i
+    // Propagation: this operation changes the number of free variables in a row
+    bool constant = constants_.test(i);
+    tableau_.eliminate(i, j, [&](index_t k) {
+        candidates_[k].epoch = 0;
+        if (constant) {
+            constants_.flip(k);
+        }
+    });
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::flippable_(index_t j) {
+    if (!bounded_.test(j) || values_.test(j) != bound_values_.test(j)) {
         return true;
     }
-    if (x.has_bound()) {
-        conflict_clause_.emplace_back(-x.bound->lit);
-    }
+    conflict_clause_.emplace_back(-bound_of_(index_[j]).lit);
     return false;
 }
 
-Solver::State Solver::select_(index_t &ret_i, index_t &ret_j) {
+template <bool Propagate, typename Index, typename Matrix>
+auto Solver<Propagate, Index, Matrix>::select_(index_t &ret_i, index_t &ret_j) -> State {
     // This implements Bland's rule selecting the variables with the smallest
     // indices for pivoting.
 
-    for (; !conflicts_.empty(); conflicts_.pop()) {
-        auto ii = conflicts_.top();
-        auto &xi = variables_[ii];
-        auto i = xi.reverse_index;
-        assert(ii == variables_[i].index);
-        xi.queued = false;
+    for (; !conflicts_.empty(); pop_conflict_()) {
+        auto ii = conflicts_.front();
+        auto i = reverse_index_[ii];
+        assert(ii == index_[i]);
+        queued_.reset(ii);
         // the queue might contain variables that meanwhile became basic
         if (i < n_non_basic_) {
             continue;
         }
         i -= n_non_basic_;
 
-        if (xi.has_bound() && xi.value != xi.bound->value) {
+        if (has_conflict_(ii)) {
             conflict_clause_.clear();
-            conflict_clause_.emplace_back(-xi.bound->lit);
-            index_t kk = variables_.size();
+            conflict_clause_.emplace_back(-bound_of_(ii).lit);
+            ret_i = i;
+            if (cached_candidate_(i, ret_j)) {
+                return State::Unknown;
+            }
+            // collect the flippable variables with the smallest indices
+            auto &cand = candidates_[i];
+            cand.size = 0;
             tableau_.update_row(i, [&](index_t j) {
-                auto jj = variables_[j].index;
-                if (jj < kk && flippable_(variables_[jj])) {
-                    kk = jj;
-                    ret_i = i;
-                    ret_j = j;
+                auto jj = index_[j];
+                if ((cand.size < candidate_count || jj < cand.variables[0]) && flippable_(j)) {
+                    index_t k = cand.size;
+                    if (k < candidate_count) {
+                        ++cand.size;
+                    }
+                    else {
+                        std::copy(cand.variables.begin() + 1, cand.variables.end(), cand.variables.begin());
+                        k = candidate_count - 1;
+                    }
+                    for (; k > 0 && cand.variables[k - 1] < jj; --k) {
+                        cand.variables[k] = cand.variables[k - 1];
+                    }
+                    cand.variables[k] = jj;
                 }
                 return true;
             });
-            if (kk == variables_.size()) {
+            cand.epoch = epoch_;
+            if (cand.size == 0) {
+                if (shortest_conflict_) {
+                    shorten_conflict_(ii);
+                }
+                statistics_.add_conflict(conflict_clause_.size());
+                if (activity_enabled_) {
+                    activity_.bump(conflict_clause_);
+                }
                 ++statistics_.unsat;
                 return State::Unsatisfiable;
             }
+            ret_j = reverse_index_[cand.variables[cand.size - 1]];
             return State::Unknown;
         }
     }
@@ -453,30 +818,387 @@ Solver::State Solver::select_(index_t &ret_i, index_t &ret_j) {
     return State::Satisfiable;
 }
 
-Propagator::Propagator(bool enable_propagate)
-: enable_propagate_{enable_propagate}  {
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::cached_candidate_(index_t i, index_t &ret_j) {
+    // Note: Unless the row has been modified or the epoch changed, variables
+    // only become unflippable. Hence, the first remaining flippable
+    // candidate is the one with the smallest index.
+    auto &cand = candidates_[i];
+    if (cand.epoch != epoch_) {
+        return false;
+    }
+    for (; cand.size > 0; --cand.size) {
+        auto j = reverse_index_[cand.variables[cand.size - 1]];
+        if (j < n_non_basic_ && flippable_(j)) {
+            ret_j = j;
+            ++statistics_.cached_candidates;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::shorten_conflict_(index_t ii) {
+    // Note: The sum of an even number of conflicting rows is satisfied.
+    // Hence, other queued conflicting rows are considered on their own.
+    for (auto kk : conflicts_) {
+        auto k = reverse_index_[kk];
+        if (kk == ii || k < n_non_basic_ || !has_conflict_(kk)) {
+            continue;
+        }
+        candidate_clause_.clear();
+        candidate_clause_.emplace_back(-bound_of_(kk).lit);
+        bool conflict = true;
+        tableau_.update_row(k - n_non_basic_, [&](index_t j) {
+            if (!bounded_.test(j) || values_.test(j) != bound_values_.test(j) ||
+                candidate_clause_.size() + 1 >= conflict_clause_.size()) {
+                conflict = false;
+                return false;
+            }
+            candidate_clause_.emplace_back(-bound_of_(index_[j]).lit);
+            return true;
+        });
+        if (conflict && candidate_clause_.size() < conflict_clause_.size()) {
+            std::swap(conflict_clause_, candidate_clause_);
+            ++statistics_.shortened;
+        }
+    }
+
+    // The sum of conflicting row `i` and a satisfied row whose variables are
+    // all bounded is conflicting, too. It is shorter if the rows share most
+    // of their columns. Sums with other non-conflicting rows contain
+    // flippable variables. To keep this cheap, only rows sharing the first
+    // column of row `i` are considered.
+    auto n = n_non_basic_;
+    auto i = reverse_index_[ii] - n;
+    conflict_columns_.clear();
+    tableau_.update_row(i, [&](index_t j) {
+        conflict_columns_.emplace_back(j);
+        return true;
+    });
+    if (conflict_columns_.empty()) {
+        return;
+    }
+    tableau_.update_col(conflict_columns_.front(), [&](index_t k) {
+        if (k == i || !bounded_.test(n + k) || conflicting_(n + k)) {
+            return;
+        }
+        candidate_clause_.clear();
+        candidate_clause_.emplace_back(-bound_of_(ii).lit);
+        candidate_clause_.emplace_back(-bound_of_(index_[n + k]).lit);
+        bool conflict = true;
+        auto add = [&](index_t j) {
+            if (candidate_clause_.size() + 1 >= conflict_clause_.size()) {
+                conflict = false;
+                return false;
+            }
+            candidate_clause_.emplace_back(-bound_of_(index_[j]).lit);
+            return true;
+        };
+        // the columns of both rows are traversed in increasing order adding
+        // the ones not shared by the rows
+        auto it = conflict_columns_.begin();
+        auto ie = conflict_columns_.end();
+        tableau_.update_row(k, [&](index_t j) {
+            for (; it != ie && *it < j; ++it) {
+                if (!add(*it)) {
+                    return false;
+                }
+            }
+            if (it != ie && *it == j) {
+                ++it;
+                return true;
+            }
+            if (!bounded_.test(j) || values_.test(j) != bound_values_.test(j)) {
+                conflict = false;
+                return false;
+            }
+            return add(j);
+        });
+        for (; conflict && it != ie; ++it) {
+            add(*it);
+        }
+        if (conflict && candidate_clause_.size() < conflict_clause_.size()) {
+            std::swap(conflict_clause_, candidate_clause_);
+            ++statistics_.shortened;
+        }
+    });
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+bool Solver<Propagate, Index, Matrix>::needs_refactor_(index_t level) const {
+    auto size = tableau_.size();
+    auto initial = tableau_base_;
+    return size > initial && (level == 0 || (refactor_factor_ > 0 && static_cast<double>(size) > refactor_factor_ * static_cast<double>(initial)));
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::refactor_() {
+    assert(conflicts_.empty());
+
+    // Every tableau obtained by pivoting describes the same linear system.
+    // Thus, the current assignment also satisfies the rebuilt tableau and
+    // values can be kept. Only positions have to be reset to the initial
+    // basis.
+    auto n = static_cast<index_t>(index_.size());
+    BitSet values;
+    BitSet bounded;
+    BitSet bound_values;
+    values.resize(n);
+    bounded.resize(n);
+    bound_values.resize(n);
+    for (index_t x = 0; x != n; ++x) {
+        auto k = reverse_index_[x];
+        values.assign(x, values_.test(k));
+        bounded.assign(x, bounded_.test(k));
+        bound_values.assign(x, bound_values_.test(k));
+        index_[x] = x;
+        reverse_index_[x] = x;
+    }
+    std::swap(values_, values);
+    std::swap(bounded_, bounded);
+    std::swap(bound_values_, bound_values);
+
+    tableau_.clear();
+    for (index_t i = 0; i != n_basic_; ++i) {
+        constants_.reset(i);
+        for (auto j : inequalities_[row_inequalities_[i]].lhs) {
+            tableau_.set(i, j, true);
+        }
+    }
+    apply_simplification_();
+    tableau_base_ = tableau_.size();
+    clear_pivot_trail_();
+
+    ++statistics_.refactors;
+    assert_extra(check_solution_());
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::revert_(TrailOffset const &offset) {
+    // Note: Pivots are kept if the tableau did not grow much. They are then
+    // attributed to the previous level and might be reverted together with
+    // its pivots.
+    if (revert_factor_ <= 0 || static_cast<double>(tableau_.size()) <= revert_factor_ * static_cast<double>(offset.tableau)) {
+        return;
+    }
+    // The restored assignment satisfies the tableau independently of the
+    // basis. Because values are stored by position, swapping the basis
+    // keeps the assignment of the variables intact.
+    for (auto it = pivot_trail_.rbegin(), ie = pivot_trail_.rend() - offset.pivot; it != ie; ++it) {
+        swap_basis_(it->first, it->second);
+        ++statistics_.reverted;
+    }
+    pivot_trail_.resize(offset.pivot);
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::clear_pivot_trail_() {
+    pivot_trail_.clear();
+    for (auto &offset : trail_offset_) {
+        offset.pivot = 0;
+    }
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::simplify_(Clingo::Assignment ass) {
+    assert(conflicts_.empty());
+    bool changed = false;
+
+    // pivots of backtracked levels that have been kept are never reverted
+    clear_pivot_trail_();
+
+    // gather variables bounded on level 0
+    for (auto it = bound_trail_.begin() + simplified_bounds_, ie = bound_trail_.end(); it != ie; ++it) {
+        fixed_.set(*it);
+        ++statistics_.fixed;
+        changed = true;
+    }
+    simplified_bounds_ = bound_trail_.size();
+
+    // gather variables of constraints that do not have to hold
+    for (index_t x = n_non_basic_, e = index_.size(); x != e; ++x) {
+        if (!free_.test(x) && ass.is_false(bounds_[bound_offsets_[x]].lit)) {
+            free_.set(x);
+            ++statistics_.dropped;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        apply_simplification_();
+        tableau_base_ = tableau_.size();
+    }
+}
+
+template <bool Propagate, typename Index, typename Matrix>
+void Solver<Propagate, Index, Matrix>::apply_simplification_() {
+    // Non-basic variables fixed on level 0 never change their value again.
+    // They are removed from the tableau and their values are added to the
+    // constant terms of the affected rows.
+    for (index_t j = 0; j != n_non_basic_; ++j) {
+        if (fixed_.test(non_basic_(j))) {
+            bool value = values_.test(j);
+            tableau_.remove_col(j, [&](index_t i) {
+                if (value) {
+                    constants_.flip(i);
+                }
+            });
+        }
+    }
+
+    // A variable without bound can take any value. If it is non-basic, it is
+    // first made basic in some row, which eliminates it from all other rows.
+    // Then the row of the basic variable is removed.
+    for (index_t x = n_non_basic_, e = index_.size(); x != e; ++x) {
+        if (!free_.test(x)) {
+            continue;
+        }
+        index_t k = reverse_index_[x];
+        if (k < n_non_basic_) {
+            index_t i = n_basic_;
+            tableau_.update_col(k, [&](index_t r) { i = std::min(i, r); });
+            if (i == n_basic_) {
+                continue;
+            }
+            swap_basis_(i, k);
+            k = reverse_index_[x];
+        }
+        auto i = k - n_non_basic_;
+        tableau_.remove_row(i);
+        constants_.assign(i, values_.test(k));
+    }
+    ++epoch_;
+
+    assert_extra(check_tableau_());
+}
+
+template class Solver<false, uint16_t>;
+template class Solver<true, uint16_t>;
+template class Solver<false, uint32_t>;
+template class Solver<true, uint32_t>;
+template class Solver<false, uint16_t, DenseTableau<1>>;
+template class Solver<true, uint16_t, DenseTableau<1>>;
+template class Solver<false, uint16_t, DenseTableau<2>>;
+template class Solver<true, uint16_t, DenseTableau<2>>;
+template class Solver<false, uint16_t, DenseTableau<4>>;
+template class Solver<true, uint16_t, DenseTableau<4>>;
+template class Solver<false, uint16_t, DenseTableau<8>>;
+template class Solver<true, uint16_t, DenseTableau<8>>;
+
+namespace {
+
+//! The names of the buckets of the conflict length histogram.
+std::array<char const *, Statistics::conflict_buckets> const conflict_bucket_names{
+    "1", "2", "3-4", "5-8", "9-16", "17-32", "33-64", "65+"};
+
+//! The names of the clause types indexed by their values.
+std::array<char const *, 4> const clause_type_names{
+    "Learnt", "Static", "Volatile", "Volatile Static"};
+
+//! Create a simplex-based solver with the given index and tableau type.
+template <typename Index, typename Matrix = Tableau<Index>>
+std::unique_ptr<AbstractSolver> make_simplex(XORStore const &iqs, Config const &config) {
+    if (config.propagate) {
+        return std::make_unique<Solver<true, Index, Matrix>>(iqs, config);
+    }
+    return std::make_unique<Solver<false, Index, Matrix>>(iqs, config);
+}
+
+//! The maximum number of bits of the dense matrix of the Gauss-Jordan
+//! engine per thread (128 MiB).
+constexpr size_t gauss_max_bits = size_t{1} << 30U;
+
+//! Create a solver for the configured engine.
+//!
+//! The simplex-based solver uses the narrowest index type for the given
+//! problem. If there are few variables, it uses a dense tableau with the
+//! smallest sufficient width. The Gauss-Jordan engine stores one dense row
+//! over all variables and slack columns per constraint. The simplex-based
+//! solver is used instead if this matrix would be too large.
+std::unique_ptr<AbstractSolver> make_solver(XORStore const &iqs, Config const &config) {
+    auto n_rows = iqs.size();
+    if (config.engine == Engine::GaussJordan && n_rows * (iqs.n_variables() + n_rows) <= gauss_max_bits) {
+        return std::make_unique<GaussSolver>(iqs, config);
+    }
+    // Note: The positions of all variables have to fit into the index type.
+    // The largest value is kept free.
+    if (iqs.n_variables() + iqs.size() < std::numeric_limits<uint16_t>::max()) {
+        auto n = iqs.n_variables();
+        if (config.dense && n <= DenseTableau<1>::columns) {
+            return make_simplex<uint16_t, DenseTableau<1>>(iqs, config);
+        }
+        if (config.dense && n <= DenseTableau<2>::columns) {
+            return make_simplex<uint16_t, DenseTableau<2>>(iqs, config);
+        }
+        if (config.dense && n <= DenseTableau<4>::columns) {
+            return make_simplex<uint16_t, DenseTableau<4>>(iqs, config);
+        }
+        if (config.dense && n <= DenseTableau<8>::columns) {
+            return make_simplex<uint16_t, DenseTableau<8>>(iqs, config);
+        }
+        return make_simplex<uint16_t>(iqs, config);
+    }
+    return make_simplex<uint32_t>(iqs, config);
+}
+
+} // namespace
+
+Propagator::Propagator(Config const &config)
+: config_{config} {
 }
 
 void Propagator::init(Clingo::PropagateInit &init) {
     facts_offset_ = facts_.size();
-    if (facts_offset_ > 0) {
+    if (facts_offset_ > 0 || (config_.check_only && config_.check_interval > 0)) {
         init.set_check_mode(Clingo::PropagatorCheckMode::Partial);
     }
 
-    evaluate_theory(init, var_map_, iqs_);
+    evaluate_theory(init, var_map_, iqs_, config_);
+    if (config_.equivalences && !substitute_equivalences(init, iqs_, classes_, preprocessing_)) {
+        return;
+    }
+    if (config_.eliminate) {
+        eliminate_variables(init, iqs_, eliminated_, preprocessing_);
+    }
+    if (config_.watched_length > 0) {
+        for (auto j = watched_iqs_.n_variables(), e = iqs_.n_variables(); j != e; ++j) {
+            watched_iqs_.add_variable(iqs_.variable(j));
+        }
+        iqs_.rewrite([&](std::vector<index_t> &lhs, Value &rhs, Clingo::literal_t lit) {
+            if (lhs.size() > config_.watched_length) {
+                return true;
+            }
+            watched_iqs_.add(lhs.begin(), lhs.end(), rhs, lit);
+            return false;
+        });
+    }
     // add watches
-    for (auto &x : iqs_) {
-        init.add_watch(x.lit);
+    for (size_t j = 0, e = iqs_.n_variables(); j != e; ++j) {
+        init.add_watch(iqs_.variable(j));
+        init.add_watch(-iqs_.variable(j));
+    }
+    for (size_t k = 0, e = iqs_.size(); k != e; ++k) {
+        init.add_watch(iqs_[k].lit);
+    }
+    for (size_t k = 0, e = watched_iqs_.size(); k != e; ++k) {
+        init.add_watch(watched_iqs_[k].lit);
     }
 
     slvs_.clear();
     slvs_.reserve(init.number_of_threads());
+    watched_slvs_.clear();
+    watched_slvs_.reserve(init.number_of_threads());
+    deferred_.resize(init.number_of_threads());
+    hints_.assign(init.number_of_threads(), 0);
+    activity_decisions_.assign(init.number_of_threads(), 0);
     for (size_t i = 0, e = init.number_of_threads(); i != e; ++i) {
-        slvs_.emplace_back(
-            std::piecewise_construct,
-            std::forward_as_tuple(0),
-            std::forward_as_tuple(iqs_, enable_propagate_));
-        if (!slvs_.back().second.prepare(init, var_map_.size())) {
+        slvs_.emplace_back(0, make_solver(iqs_, config_));
+        if (!slvs_.back().second->prepare(init)) {
+            return;
+        }
+        if (!watched_slvs_.emplace_back(watched_iqs_).prepare(init)) {
             return;
         }
     }
@@ -493,34 +1215,83 @@ void Propagator::on_statistics(Clingo::UserStatistics step, Clingo::UserStatisti
     auto basic = simplex.add_subkey("Basic", Clingo::StatisticsType::Value);
     auto non_basic = simplex.add_subkey("Nonbasic", Clingo::StatisticsType::Value);
     auto bounds = simplex.add_subkey("Bounds", Clingo::StatisticsType::Value);
+    auto equivalences = simplex.add_subkey("Equivalences", Clingo::StatisticsType::Value);
+    auto watched = simplex.add_subkey("Watched Rows", Clingo::StatisticsType::Value);
+    auto merged = simplex.add_subkey("Merged Rows", Clingo::StatisticsType::Value);
+    auto eliminated_rows = simplex.add_subkey("Eliminated Rows", Clingo::StatisticsType::Value);
+    auto eliminated_vars = simplex.add_subkey("Eliminated Variables", Clingo::StatisticsType::Value);
     auto threads = simplex.add_subkey("Threads", Clingo::StatisticsType::Array);
-    auto const &master_stats = slvs_.front().second.statistics();
+    auto const &master_stats = slvs_.front().second->statistics();
 
     // global values
     basic.set_value(master_stats.basic);
     non_basic.set_value(master_stats.non_basic);
     bounds.set_value(master_stats.bounds);
+    equivalences.set_value(preprocessing_.equivalences);
+    watched.set_value(watched_iqs_.size());
+    merged.set_value(preprocessing_.merged_rows);
+    eliminated_rows.set_value(preprocessing_.eliminated_rows);
+    eliminated_vars.set_value(preprocessing_.eliminated_variables);
     tableaux.set_value(master_stats.tableau_initial);
 
     // per thread values
     size_t thread_id = 0;
     threads.ensure_size(slvs_.size(), Clingo::StatisticsType::Map);
     for (auto const &[offset, slv] : slvs_) {
+        auto const &watched_slv = watched_slvs_[thread_id];
+        auto n_hints = hints_[thread_id];
+        auto n_activity = activity_decisions_[thread_id];
         auto thread = threads[thread_id++];
         auto time = thread.add_subkey("Time", Clingo::StatisticsType::Map);
         auto total = time.add_subkey("Total", Clingo::StatisticsType::Value);
         auto propagate = time.add_subkey("Propagate", Clingo::StatisticsType::Value);
         auto avg = thread.add_subkey("Average Tableau Size", Clingo::StatisticsType::Value);
         auto pivots = thread.add_subkey("Pivots", Clingo::StatisticsType::Value);
+        auto refactors = thread.add_subkey("Refactorizations", Clingo::StatisticsType::Value);
+        auto reverted = thread.add_subkey("Reverted Pivots", Clingo::StatisticsType::Value);
+        auto cached = thread.add_subkey("Cached Candidates", Clingo::StatisticsType::Value);
+        auto fixed = thread.add_subkey("Fixed Variables", Clingo::StatisticsType::Value);
+        auto dropped = thread.add_subkey("Dropped Rows", Clingo::StatisticsType::Value);
+        auto equivalences = thread.add_subkey("Derived Equivalences", Clingo::StatisticsType::Value);
+        auto shortened = thread.add_subkey("Shortened Conflicts", Clingo::StatisticsType::Value);
+        auto lengths = thread.add_subkey("Conflict Lengths", Clingo::StatisticsType::Map);
+        auto skipped = thread.add_subkey("Skipped Reasons", Clingo::StatisticsType::Value);
+        auto exhausted = thread.add_subkey("Exhausted Budgets", Clingo::StatisticsType::Value);
+        auto hints = thread.add_subkey("Phase Hints", Clingo::StatisticsType::Value);
+        auto activity = thread.add_subkey("Activity Decisions", Clingo::StatisticsType::Value);
+        auto clauses = thread.add_subkey("Clauses", Clingo::StatisticsType::Map);
         auto sat = thread.add_subkey("SAT", Clingo::StatisticsType::Value);
         auto unsat = thread.add_subkey("UNSAT", Clingo::StatisticsType::Value);
+        auto watched_propagations = thread.add_subkey("Watched Propagations", Clingo::StatisticsType::Value);
+        auto watched_conflicts = thread.add_subkey("Watched Conflicts", Clingo::StatisticsType::Value);
 
-        auto const &stats = slv.statistics();
+        auto const &stats = slv->statistics();
         pivots.set_value(pivots.value() + stats.pivots);
+        refactors.set_value(refactors.value() + stats.refactors);
+        reverted.set_value(reverted.value() + stats.reverted);
+        cached.set_value(cached.value() + stats.cached_candidates);
+        fixed.set_value(fixed.value() + stats.fixed);
+        dropped.set_value(dropped.value() + stats.dropped);
+        equivalences.set_value(equivalences.value() + stats.equivalences);
+        shortened.set_value(shortened.value() + stats.shortened);
+        for (size_t b = 0; b != Statistics::conflict_buckets; ++b) {
+            auto length = lengths.add_subkey(conflict_bucket_names[b], Clingo::StatisticsType::Value);
+            length.set_value(length.value() + stats.conflict_lengths[b]);
+        }
+        skipped.set_value(skipped.value() + stats.skipped_reasons);
+        exhausted.set_value(exhausted.value() + stats.exhausted);
+        hints.set_value(hints.value() + n_hints);
+        activity.set_value(activity.value() + n_activity);
+        for (size_t t = 0; t != stats.clauses.size(); ++t) {
+            auto count = clauses.add_subkey(clause_type_names[t], Clingo::StatisticsType::Value);
+            count.set_value(count.value() + stats.clauses[t]);
+        }
         total.set_value(total.value() + stats.total.total());
         propagate.set_value(propagate.value() + stats.propagate.total());
         sat.set_value(sat.value() + stats.sat);
         unsat.set_value(unsat.value() + stats.unsat);
+        watched_propagations.set_value(watched_propagations.value() + watched_slv.propagations());
+        watched_conflicts.set_value(watched_conflicts.value() + watched_slv.conflicts());
         avg.set_value(stats.tableau_average);
     }
 }
@@ -529,11 +1300,91 @@ void Propagator::check(Clingo::PropagateControl &ctl) {
     auto ass = ctl.assignment();
     auto &[offset, slv] = slvs_[ctl.thread_id()];
     if (ass.decision_level() == 0 && offset < facts_offset_) {
-        if (!slv.solve(ctl, Clingo::LiteralSpan{facts_.data() + offset, facts_offset_})) { // NOLINT
+        if (!slv->solve(ctl, Clingo::LiteralSpan{facts_.data() + offset, facts_offset_})) { // NOLINT
             return;
         }
         offset = facts_offset_;
     }
+    // Note: Solving has to finish on total assignments. On partial
+    // assignments, pivoting continues on the next propagation.
+    if (ass.is_total() && !slv->finish(ctl)) {
+        return;
+    }
+    auto level = ass.decision_level();
+    if (config_.check_only && level > 0 &&
+        (ass.is_total() || (config_.check_interval > 0 && level % config_.check_interval == 0))) {
+        if (!check_deferred_(ctl)) {
+            return;
+        }
+    }
+    check_eliminated_(ctl);
+}
+
+bool Propagator::check_deferred_(Clingo::PropagateControl &ctl) {
+    auto ass = ctl.assignment();
+    auto &deferred = deferred_[ctl.thread_id()];
+    auto add = [&](Clingo::literal_t lit) {
+        if (ass.is_true(lit) && ass.level(lit) > 0) {
+            deferred.emplace_back(lit);
+        }
+    };
+    deferred.clear();
+    for (size_t j = 0, e = iqs_.n_variables(); j != e; ++j) {
+        add(iqs_.variable(j));
+        add(-iqs_.variable(j));
+    }
+    for (size_t k = 0, e = iqs_.size(); k != e; ++k) {
+        add(iqs_[k].lit);
+    }
+    std::sort(deferred.begin(), deferred.end());
+    deferred.erase(std::unique(deferred.begin(), deferred.end()), deferred.end());
+
+    // Note: The literals on level 0 have already been passed to the solver
+    // during propagation.
+    auto &slv = *slvs_[ctl.thread_id()].second;
+    bool ret = slv.solve(ctl, deferred) && slv.finish(ctl);
+    slv.undo(ass.decision_level());
+    return ret;
+}
+
+bool Propagator::check_eliminated_(Clingo::PropagateControl &ctl) {
+    auto ass = ctl.assignment();
+    std::vector<Clingo::literal_t> clause;
+    for (size_t k = 0, e = eliminated_.size(); k != e; ++k) {
+        auto x = eliminated_[k];
+        assert(ass.is_true(x.lit));
+        clause.clear();
+        Value sum = x.rhs;
+        Clingo::literal_t free = 0;
+        size_t n_free = 0;
+        for (auto var : x.lhs) {
+            auto lit = iqs_.variable(var);
+            if (ass.is_true(lit)) {
+                sum ^= Value{true};
+                clause.emplace_back(-lit);
+            }
+            else if (ass.is_false(lit)) {
+                clause.emplace_back(lit);
+            }
+            else if (++n_free > 1) {
+                break;
+            }
+            else {
+                free = lit;
+            }
+        }
+        // the constraint is satisfied or not yet unit
+        if (n_free > 1 || (n_free == 0 && !sum)) {
+            continue;
+        }
+        if (n_free == 1) {
+            clause.emplace_back(sum ? free : -free);
+        }
+        if (!ctl.add_clause(clause) || !ctl.propagate()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void Propagator::propagate(Clingo::PropagateControl &ctl, Clingo::LiteralSpan changes) {
@@ -542,11 +1393,45 @@ void Propagator::propagate(Clingo::PropagateControl &ctl, Clingo::LiteralSpan ch
         facts_.insert(facts_.end(), changes.begin(), changes.end());
     }
     auto &[offset, slv] = slvs_[ctl.thread_id()];
-    if (!slv.solve(ctl, changes)) {
+    // Note: In check-only mode, the solver only keeps the assignment on
+    // level 0.
+    if ((!config_.check_only || ass.decision_level() == 0) && !slv->solve(ctl, changes)) {
         return;
     }
+    // Note: The watched solver does not keep a trail. Hence, unlike the
+    // solver above, it does not have to be called on every level.
+    if (!watched_slvs_[ctl.thread_id()].solve(ctl, changes)) {
+        return;
+    }
+}
+
+Clingo::literal_t Propagator::decide(Clingo::id_t thread_id, Clingo::Assignment const &assignment, Clingo::literal_t fallback) {
+    if (config_.activity) {
+        auto lit = slvs_[thread_id].second->decide(assignment);
+        if (lit != 0) {
+            ++activity_decisions_[thread_id];
+            return lit;
+        }
+    }
+    if (!config_.phase) {
+        return fallback;
+    }
+    // Note: The variable map contains the literal of a variable with either
+    // sign.
+    auto it = var_map_.find(fallback);
+    if (it == var_map_.end()) {
+        it = var_map_.find(-fallback);
+    }
+    if (it == var_map_.end() || it->second >= iqs_.n_variables()) {
+        return fallback;
+    }
+    ++hints_[thread_id];
+    auto value = static_cast<bool>(slvs_[thread_id].second->get_value(it->second));
+    return value ? it->first : -it->first;
 }
 
 void Propagator::undo(Clingo::PropagateControl const &ctl, Clingo::LiteralSpan changes) noexcept {
-    slvs_[ctl.thread_id()].second.undo();
+    // Note: In check-only mode, the solver only holds assignments on level 0
+    // and nothing but the activity heap is restored.
+    slvs_[ctl.thread_id()].second->undo(ctl.assignment().decision_level());
 }
@@ -2,14 +2,26 @@
 
 #include "problem.hh"
 #include "parsing.hh"
+#include "preprocessing.hh"
+#include "watched.hh"
 #include "util.hh"
 
-#include <queue>
+#include <algorithm>
+#include <array>
 #include <map>
 #include <optional>
+#include <limits>
 
 struct Statistics {
+    //! The number of buckets of the conflict length histogram.
+    static constexpr size_t conflict_buckets = 8;
+
     void reset();
+    //! Record a conflict clause with the given length.
+    //!
+    //! Bucket `b` counts clauses with length in range (2^(b-1), 2^b] and the
+    //! last bucket all longer clauses.
+    void add_conflict(size_t length);
 
     Timer total;
     Timer propagate;
@@ -17,59 +29,171 @@ struct Statistics {
     double tableau_average{0};
     size_t tableau_average_n{0};
     size_t pivots{0};
+    size_t refactors{0};
+    size_t fixed{0};
+    size_t dropped{0};
+    size_t equivalences{0};
+    size_t shortened{0};
     size_t sat{0};
     size_t unsat{0};
     size_t basic{0};
     size_t non_basic{0};
     size_t bounds{0};
+    size_t skipped_reasons{0};
+    size_t exhausted{0};
+    size_t reverted{0};
+    size_t cached_candidates{0};
+    std::array<size_t, conflict_buckets> conflict_lengths{};
+    //! The number of added clauses indexed by clause type.
+    std::array<size_t, 4> clauses{};
+};
+
+//! Add a conflict or reason clause of the given type.
+//!
+//! Reasons with more than `reason_length` literals (0 for no limit) are not
+//! added. The engines detect the violated constraint again once the literal
+//! that would have been propagated is assigned. Conflicts are always added.
+bool add_clause(Clingo::PropagateControl &ctl, Clingo::LiteralSpan clause, Clingo::ClauseType type, size_t reason_length, bool conflict, Statistics &stats);
+
+//! Conflict activity of the variables used to select decisions.
+//!
+//! Variables in conflict clauses are bumped. Decisions pick the unassigned
+//! variable with the highest activity if it has been bumped at all.
+//! Variables found assigned are removed from the heap and added back when
+//! backtracking.
+class ConflictActivity {
+public:
+    //! Set up the activities for the variables of the given constraints.
+    void init(XORStore const &iqs);
+    //! Bump the variables of the given conflict clause.
+    void bump(Clingo::LiteralSpan clause);
+    //! Add the variables removed by decide back to the heap.
+    void restore();
+    //! Select the unassigned variable with the highest activity.
+    //!
+    //! The polarity is taken from `value(i)`. Returns 0 if all variables
+    //! are assigned or no unassigned variable occurred in a conflict.
+    template <class F>
+    [[nodiscard]] Clingo::literal_t decide(Clingo::Assignment const &ass, F &&value) {
+        while (!heap_.empty()) {
+            auto i = heap_.top();
+            auto lit = lits_[i];
+            if (!ass.is_true(lit) && !ass.is_false(lit)) {
+                if (heap_.activity(i) == 0) {
+                    return 0;
+                }
+                return value(i) ? lit : -lit;
+            }
+            heap_.pop();
+            removed_.emplace_back(i);
+        }
+        return 0;
+    }
+
+private:
+    ActivityHeap heap_;
+    //! The literals of the variables.
+    std::vector<Clingo::literal_t> lits_;
+    //! Map from literals to the variables they belong to.
+    std::unordered_map<Clingo::literal_t, index_t> vars_;
+    //! Variables removed from the heap because they were assigned.
+    std::vector<index_t> removed_;
+};
+
+//! The interface of a solver for finding an assignment satisfying a set of
+//! inequalities.
+class AbstractSolver {
+public:
+    AbstractSolver() = default;
+    AbstractSolver(AbstractSolver const &) = delete;
+    AbstractSolver(AbstractSolver &&) = delete;
+    AbstractSolver &operator=(AbstractSolver const &) = delete;
+    AbstractSolver &operator=(AbstractSolver &&) = delete;
+    virtual ~AbstractSolver() = default;
+
+    //! Prepare inequalities for solving.
+    [[nodiscard]] virtual bool prepare(Clingo::PropagateInit &init) = 0;
+
+    //! Solve the (previously prepared) problem.
+    //!
+    //! If the function returns false, the solver has to backtrack.
+    [[nodiscard]] virtual bool solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits) = 0;
+
+    //! Finish solving if a previous call to solve ran out of its budget.
+    //!
+    //! If the function returns false, the solver has to backtrack.
+    [[nodiscard]] virtual bool finish(Clingo::PropagateControl &ctl) = 0;
+
+    //! Undo assignments on the given and all higher levels.
+    //!
+    //! Levels the solver has not been called on are ignored except that
+    //! variables removed from the activity heap are restored.
+    virtual void undo(index_t level) = 0;
+
+    //! Get the currently assigned value.
+    [[nodiscard]] virtual Value get_value(index_t i) const = 0;
+
+    //! Select an unassigned variable with high conflict activity.
+    //!
+    //! Returns 0 if activities are disabled or all variables are assigned.
+    [[nodiscard]] virtual Clingo::literal_t decide(Clingo::Assignment const &ass) = 0;
+
+    //! Return the solve statistics.
+    [[nodiscard]] virtual Statistics const &statistics() const = 0;
 };
 
 //! A solver for finding an assignment satisfying a set of inequalities.
-class Solver {
+//!
+//! Variables are stored column-wise in a number of dense arrays so that
+//! pivoting and flipping only touch the data they need.
+//!
+//! The solver is specialized on whether propagation is enabled, the type
+//! used to index rows and columns of the tableau, and the type of the
+//! tableau. Small problems use a dense tableau with a fixed number of
+//! columns.
+template <bool Propagate, typename Index, typename Matrix = Tableau<Index>>
+class Solver final : public AbstractSolver {
 private:
     //! The bounds associated with a Variable.
     //!
-    //! In practice, there should be a lot of variables with just one bound.
+    //! Each variable has at most two bounds.
     struct Bound {
         Value value;
         index_t variable{0};
         Clingo::literal_t lit{0};
     };
-    //! Capture the current state of a variable.
-    struct Variable {
-        //! Adjusts the bound of the variable if possible.
-        [[nodiscard]] bool update_bound(Solver &s, Clingo::Assignment ass, Bound const &bound);
-        //! Check if te value of the variable conflicts with its bound.
-        [[nodiscard]] bool has_conflict() const;
-        //! Check if the variable has a bound.
-        [[nodiscard]] bool has_bound() const { return bound != nullptr; }
-        //! Flip the value of the variable.
-        void flip_value(Solver &s, index_t level);
-
-        //! The bounds associated with the variable.
-        std::vector<Bound*> bounds;
-        //! The bound of a variable.
-        Bound const *bound{nullptr};
-        //! Helper index for pivoting variables.
-        index_t index{0};
-        //! Helper index to obtain row/column index of a variable.
-        index_t reverse_index{0};
-        //! The level the variable was assigned on.
-        index_t level{0};
-        //! The current value of the variable.
-        Value value{false};
-        //! Whether this variales is in the queue of conflicting variables.
-        bool queued{false};
-        //! Whether the row has to be propagated.
-        //!
-        //! Note that this is not really associated with the variable. This is
-        //! just a convenient location to store the flag.
-        bool in_propagate_set{false};
-    };
     struct TrailOffset {
         index_t level;
         index_t bound;
         index_t assignment;
+        //! Offset into the pivot trail.
+        index_t pivot;
+        //! The size of the tableau at the beginning of the level.
+        size_t tableau;
+        //! Whether the assignment does not yet satisfy the bounds because
+        //! the pivot budget was exhausted.
+        bool incomplete{false};
+    };
+    //! The number of pivot candidates cached per row.
+    static constexpr index_t candidate_count = 4;
+    //! The flippable variables with the smallest indices in a row.
+    //!
+    //! Variables are stored in descending order. The candidates are invalid
+    //! if the row has been modified by an elimination or the epoch changed.
+    struct Candidates {
+        std::array<index_t, candidate_count> variables{};
+        index_t size{0};
+        size_t epoch{0};
+    };
+    //! The hash of the last equivalence derived from a row.
+    //!
+    //! Unless the clauses are static, clingo might delete them. The hash is
+    //! then only valid as long as the decision on the level it was recorded
+    //! on has not been backtracked.
+    struct BinaryHash {
+        uint64_t hash{0};
+        index_t level{0};
+        Clingo::literal_t decision{0};
     };
     //! Captures what is know about of the satisfiability of a problem while
     //! solving.
@@ -78,27 +202,20 @@ private:
         Unsatisfiable = 1,
         Unknown = 2
     };
+    //! Marker for variables without a bound.
+    static constexpr index_t no_bound = std::numeric_limits<index_t>::max();
 
 public:
     //! Construct a new solver object.
-    Solver(std::vector<XORConstraint> const &inequalities, bool enable_propagate);
-
-    //! Prepare inequalities for solving.
-    [[nodiscard]] bool prepare(Clingo::PropagateInit &init, size_t n_variables);
-
-    //! Solve the (previously prepared) problem.
-    //!
-    //! If the function returns false, the solver has to backtrack.
-    [[nodiscard]] bool solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits);
+    Solver(XORStore const &inequalities, Config const &config);
 
-    //! Undo assignments on the current level.
-    void undo();
-
-    //! Get the currently assigned value.
-    [[nodiscard]] Value get_value(index_t i) const;
-
-    //! Return the solve statistics.
-    [[nodiscard]] Statistics const &statistics() const;
+    [[nodiscard]] bool prepare(Clingo::PropagateInit &init) override;
+    [[nodiscard]] bool solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits) override;
+    [[nodiscard]] bool finish(Clingo::PropagateControl &ctl) override;
+    void undo(index_t level) override;
+    [[nodiscard]] Value get_value(index_t i) const override;
+    [[nodiscard]] Clingo::literal_t decide(Clingo::Assignment const &ass) override;
+    [[nodiscard]] Statistics const &statistics() const override;
 
 private:
     //! Check if the tableau.
@@ -110,6 +227,25 @@ private:
     //! Check if the current assignment is a solution.
     [[nodiscard]] bool check_solution_();
 
+    //! Check if variable `x` has a bound.
+    [[nodiscard]] bool has_bound_(index_t x) const;
+    //! Get the bound of variable `x`.
+    [[nodiscard]] Bound const &bound_of_(index_t x) const;
+    //! Check if the value of variable `x` conflicts with its bound.
+    [[nodiscard]] bool has_conflict_(index_t x) const;
+    //! Check if the variable at position `k` conflicts with its bound.
+    [[nodiscard]] bool conflicting_(index_t k) const;
+    //! Find the first conflicting position in range [begin, end).
+    //!
+    //! Returns `end` if there is no such position.
+    [[nodiscard]] index_t find_conflicting_(index_t begin, index_t end) const;
+    //! Adjusts the bound of variable `x` if possible.
+    [[nodiscard]] bool update_bound_(index_t x, index_t bound);
+    //! Flip the value of the variable at position `k`.
+    void flip_value_(index_t level, index_t k);
+
+    //! Remove the smallest variable from the queue of conflicting variables.
+    void pop_conflict_();
     //! Enqueue basic variable `x_i` if it is conflicting.
     void enqueue_(index_t i);
 
@@ -120,18 +256,58 @@ private:
 
     //! Propagate marked rows.
     bool propagate_(Clingo::PropagateControl &ctl);
+    //! Pivot until the bounds are satisfied, a conflict is found, or the
+    //! given number of pivots (0 for no limit) has been performed.
+    //!
+    //! Values are recorded on the trail for the given level.
+    bool pivot_loop_(Clingo::PropagateControl &ctl, index_t level, size_t budget);
+    //! Add the equivalence between variables `x` and `y` implied by row `i`.
+    //!
+    //! The conflict clause must hold the reasons for the equivalence.
+    bool propagate_binary_(Clingo::PropagateControl &ctl, index_t i, index_t x, index_t y);
+    //! Get the cached pivot candidate of conflicting row `i`.
+    //!
+    //! Returns false if the candidates have to be recomputed.
+    bool cached_candidate_(index_t i, index_t &ret_j);
+    //! Replace the conflict clause by a shorter one if another queued row
+    //! is conflicting or the sum of the conflicting row and a bounded row
+    //! is shorter.
+    void shorten_conflict_(index_t ii);
 
     //! Flip the value of non-basic `x_j` variable.
     void update_(index_t level, index_t j);
 
     //! Pivots basic variable `x_i` and non-basic variable `x_j`.
     void pivot_(index_t level, index_t i, index_t j);
+    //! Exchange basic variable `x_i` and non-basic variable `x_j` without
+    //! adjusting the assignment.
+    void swap_basis_(index_t i, index_t j);
+
+    //! Simplify the tableau using the assignment on level 0.
+    void simplify_(Clingo::Assignment ass);
+    //! Remove fixed variables and rows of free variables from the tableau.
+    void apply_simplification_();
+
+    //! Check if the tableau should be refactored.
+    [[nodiscard]] bool needs_refactor_(index_t level) const;
+    //! Rebuild the tableau from the initial basis.
+    //!
+    //! This must only be called if the current assignment is satisfying.
+    void refactor_();
+    //! Revert the pivots recorded since the given trail offset if the
+    //! tableau grew too much.
+    void revert_(TrailOffset const &offset);
+    //! Forget all recorded pivots.
+    //!
+    //! This has to be called whenever the tableau is modified by other
+    //! means than pivoting.
+    void clear_pivot_trail_();
 
     //! Check if the given non-basic variable is flippable.
     //!
     //! If the variable cannot be flipped, the literal of its bound is
     //! proactively added to the conflict clause as a side effect.
-    [[nodiscard]] bool flippable_(Variable const &x);
+    [[nodiscard]] bool flippable_(index_t j);
     //! Select pivot point using Bland's rule.
     //!
     //! If the problem is unsatisfiable, the conflict clause is set as a side
@@ -139,46 +315,136 @@ private:
     State select_(index_t &ret_i, index_t &ret_j);
 
     //! Get basic variable associated with row `i`.
-    Variable &basic_(index_t i);
+    [[nodiscard]] index_t basic_(index_t i) const;
     //! Get non-basic variable associated with column `j`.
-    Variable &non_basic_(index_t j);
+    [[nodiscard]] index_t non_basic_(index_t j) const;
 
     //! The set of inequalities.
-    std::vector<XORConstraint> const &inequalities_;
+    XORStore const &inequalities_;
+    //! The inequalities associated with the rows of the initial tableau.
+    std::vector<index_t> row_inequalities_;
+    //! The bounds grouped by variable.
+    std::vector<Bound> bounds_;
+    //! Offsets of the bounds of each variable in bounds_.
+    std::vector<index_t> bound_offsets_;
     //! Mapping from literals to bounds.
-    std::unordered_multimap<Clingo::literal_t, Bound> bounds_;
+    std::unordered_multimap<Clingo::literal_t, index_t> lit_bounds_;
     //! Trail of bound assignments (variable, relation, Value).
     std::vector<index_t> bound_trail_;
     //! Trail for assignments (level, variable, Value).
+    //!
+    //! Note that variables are stored because positions change when
+    //! pivoting.
     std::vector<std::tuple<index_t, index_t, Value>> assignment_trail_;
+    //! Trail of pivots (row, column) on levels above 0.
+    //!
+    //! Since pivoting is an involution, pivoting the same row and column
+    //! again restores the previous tableau.
+    std::vector<std::pair<index_t, index_t>> pivot_trail_;
     //! Trail offsets per level.
     std::vector<TrailOffset> trail_offset_;
     //! The tableau of coefficients.
-    Tableau tableau_;
-    //! The non-basic and basic variables.
-    std::vector<Variable> variables_;
+    Matrix tableau_;
+    //! Map from row/column indices to variables.
+    //!
+    //! The first n_non_basic_ entries are associated with columns and the
+    //! remaining ones with rows.
+    std::vector<Index> index_;
+    //! Map from variables to row/column indices.
+    std::vector<Index> reverse_index_;
+    //! The level each variable was assigned on.
+    std::vector<index_t> level_;
+    //! The current bound of each variable.
+    std::vector<index_t> bound_;
+    //! The current values of the variables.
+    //!
+    //! Like the bit sets below, this is indexed by position, i.e., column
+    //! `j` is at bit `j` and row `i` at bit `n_non_basic_ + i`.
+    BitSet values_;
+    //! Whether the variables have a bound.
+    BitSet bounded_;
+    //! The values of the bounds of the variables.
+    BitSet bound_values_;
+    //! Whether a variable is in the queue of conflicting variables.
+    BitSet queued_;
+    //! Whether a row is in the propagate set.
+    BitSet in_propagate_set_;
+    //! Whether a column is in the batch of bounded columns.
+    BitSet in_batch_;
+    //! The constant terms of the rows.
+    //!
+    //! These are non-zero if fixed variables have been removed from rows.
+    BitSet constants_;
+    //! The variables with a bound on level 0.
+    BitSet fixed_;
+    //! The variables of constraints with a false literal on level 0.
+    BitSet free_;
+    //! The number of bounds on the trail that have been simplified.
+    index_t simplified_bounds_{0};
+    //! The size of the tableau after the last refactorization.
+    size_t tableau_base_{0};
     //! The set of conflicting variables.
-    std::priority_queue<index_t, std::vector<index_t>, std::greater<>> conflicts_;
+    //!
+    //! This is a min-heap so that the queued variables can be inspected
+    //! when searching for a short conflict.
+    std::vector<index_t> conflicts_;
     //! The conflict clause.
     std::vector<Clingo::literal_t> conflict_clause_;
+    //! Candidate conflict clause when searching for a shorter conflict.
+    std::vector<Clingo::literal_t> candidate_clause_;
+    //! The columns of the conflicting row when searching for a shorter
+    //! conflict.
+    std::vector<index_t> conflict_columns_;
     //! The rowes to be propagated.
-    std::vector<Clingo::literal_t> propagate_set_;
+    std::vector<index_t> propagate_set_;
+    //! The columns of non-basic variables bounded in the current call to
+    //! solve.
+    std::vector<index_t> batch_columns_;
+    //! The rows of basic variables bounded in the current call to solve.
+    std::vector<index_t> batch_rows_;
+    //! Cached pivot candidates per row.
+    std::vector<Candidates> candidates_;
+    //! The current epoch of the pivot candidates.
+    //!
+    //! It is incremented whenever variables might become flippable again.
+    size_t epoch_{1};
+    //! Hashes of the last equivalence derived from each row.
+    //!
+    //! This avoids adding the same clauses over and over again.
+    std::vector<BinaryHash> binary_hashes_;
     //! Problem and solving statistics.
     Statistics statistics_;
     //! The number of non-basic variables.
     index_t n_non_basic_{0};
     //! The number of basic variables.
     index_t n_basic_{0};
-    //! Whether propagation is enabled.
-    bool enable_propagate_;
+    //! The growth factor of the tableau triggering refactorization.
+    double refactor_factor_;
+    //! The growth factor of the tableau on a level triggering reverting its
+    //! pivots.
+    double revert_factor_;
+    //! Whether to derive equivalences from rows with two free variables.
+    bool propagate_binary_enabled_;
+    //! Whether to select the shortest conflict among the queued rows.
+    bool shortest_conflict_;
+    //! The type of added clauses.
+    Clingo::ClauseType clause_type_;
+    //! The maximum length of added reasons.
+    size_t reason_length_;
+    //! The maximum number of pivots per call to solve.
+    size_t pivot_budget_;
+    //! The conflict activity of the variables.
+    ConflictActivity activity_;
+    //! Whether conflict activities are maintained.
+    bool activity_enabled_;
 };
 
 class Propagator : public Clingo::Propagator {
 public:
-    Propagator(bool enable_propagate);
-    Propagator(Propagator const &) = default;
+    Propagator(Config const &config);
+    Propagator(Propagator const &) = delete;
     Propagator(Propagator &&) noexcept = default;
-    Propagator &operator=(Propagator const &) = default;
+    Propagator &operator=(Propagator const &) = delete;
     Propagator &operator=(Propagator &&) noexcept = default;
     ~Propagator() override = default;
     void register_control(Clingo::Control &ctl);
@@ -188,12 +454,41 @@ public:
     void check(Clingo::PropagateControl &ctl) override;
     void propagate(Clingo::PropagateControl &ctl, Clingo::LiteralSpan changes) override;
     void undo(Clingo::PropagateControl const &ctl, Clingo::LiteralSpan changes) noexcept override;
+    //! Decide on the polarity of XOR variables using the solver's
+    //! assignment.
+    Clingo::literal_t decide(Clingo::id_t thread_id, Clingo::Assignment const &assignment, Clingo::literal_t fallback) override;
 
 private:
+    //! Check the eliminated constraints.
+    //!
+    //! A clause is added for each eliminated constraint that is violated or
+    //! has exactly one unassigned variable.
+    bool check_eliminated_(Clingo::PropagateControl &ctl);
+    //! Solve the constraints w.r.t. all literals assigned above level 0.
+    //!
+    //! This is used in check-only mode. The solver is reset afterward so
+    //! that nothing has to be undone when backtracking.
+    bool check_deferred_(Clingo::PropagateControl &ctl);
+
     VarMap var_map_;
-    std::vector<XORConstraint> iqs_;
+    XORStore iqs_;
+    EquivalenceClasses classes_;
+    //! Constraints removed from the tableau during preprocessing.
+    XORStore eliminated_;
+    PreprocessingStatistics preprocessing_;
     size_t facts_offset_{0};
     std::vector<Clingo::literal_t> facts_;
-    std::vector<std::pair<size_t, Solver>> slvs_;
-    bool enable_propagate_;
+    std::vector<std::pair<size_t, std::unique_ptr<AbstractSolver>>> slvs_;
+    //! Short constraints handled by watched solvers.
+    XORStore watched_iqs_;
+    std::vector<WatchedSolver> watched_slvs_;
+    //! The number of decisions whose polarity was taken from the solver's
+    //! assignment per thread.
+    std::vector<size_t> hints_;
+    //! The number of decisions on variables with high conflict activity per
+    //! thread.
+    std::vector<size_t> activity_decisions_;
+    //! Literals passed to the solvers in check-only mode.
+    std::vector<std::vector<Clingo::literal_t>> deferred_;
+    Config config_;
 };
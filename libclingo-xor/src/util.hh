@@ -2,12 +2,18 @@
 
 #include <unordered_map>
 #include <vector>
+#include <array>
 #include <cstdint>
+#include <limits>
 #include <cassert>
 #include <iostream>
 #include <memory>
 #include <algorithm>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
 
 #ifdef CLINGOXOR_CROSSCHECK
 #   define assert_extra(X) assert(X) // NOLINT
@@ -65,19 +71,137 @@ private:
     bool value_{false};
 };
 
+//! A dense set of bits packed into 64-bit words.
+class BitSet {
+public:
+    //! Resize the set to hold `n` bits, new bits are cleared.
+    void resize(size_t n) {
+        words_.resize((n + 63) / 64, 0);
+        if (n < size_ && n % 64 != 0) {
+            words_.back() &= (uint64_t{1} << (n % 64)) - 1;
+        }
+        size_ = n;
+    }
+
+    //! Get the number of bits in the set.
+    [[nodiscard]] size_t size() const {
+        return size_;
+    }
+
+    //! Test bit `i`.
+    [[nodiscard]] bool test(size_t i) const {
+        assert(i < size_);
+        return (words_[i / 64] >> (i % 64)) & 1U;
+    }
+
+    //! Set bit `i`.
+    void set(size_t i) {
+        assert(i < size_);
+        words_[i / 64] |= uint64_t{1} << (i % 64);
+    }
+
+    //! Clear bit `i`.
+    void reset(size_t i) {
+        assert(i < size_);
+        words_[i / 64] &= ~(uint64_t{1} << (i % 64));
+    }
+
+    //! Set bit `i` to the given value.
+    void assign(size_t i, bool value) {
+        if (value) {
+            set(i);
+        }
+        else {
+            reset(i);
+        }
+    }
+
+    //! Flip bit `i`.
+    void flip(size_t i) {
+        assert(i < size_);
+        words_[i / 64] ^= uint64_t{1} << (i % 64);
+    }
+
+    //! Exchange bits `i` and `j`.
+    void swap(size_t i, size_t j) {
+        if (test(i) != test(j)) {
+            flip(i);
+            flip(j);
+        }
+    }
+
+    //! Compute the symmetric difference with a set of the same size.
+    BitSet &operator^=(BitSet const &other) {
+        assert(size_ == other.size_);
+        for (size_t k = 0, e = words_.size(); k != e; ++k) {
+            words_[k] ^= other.words_[k];
+        }
+        return *this;
+    }
+
+    //! Get the `k`-th word of the set.
+    [[nodiscard]] uint64_t word(size_t k) const {
+        return words_[k];
+    }
+
+    //! Find the first bit in range [begin, end) set in the word computed by
+    //! the given function.
+    //!
+    //! The function is called with word indices and should combine the
+    //! corresponding words of one or more bit sets. If there is no such bit,
+    //! `end` is returned.
+    template <typename F>
+    [[nodiscard]] static size_t find_first(size_t begin, size_t end, F &&f) {
+        for (size_t k = begin / 64, ke = (end + 63) / 64; k < ke; ++k) {
+            uint64_t w = f(k);
+            if (k == begin / 64) {
+                w &= ~uint64_t{0} << (begin % 64);
+            }
+            if (k + 1 == ke && end % 64 != 0) {
+                w &= (uint64_t{1} << (end % 64)) - 1;
+            }
+            if (w != 0) {
+                return k * 64 + count_trailing_zeros_(w);
+            }
+        }
+        return end;
+    }
+
+private:
+    [[nodiscard]] static size_t count_trailing_zeros_(uint64_t w) {
+        assert(w != 0);
+#if defined(__GNUC__)
+        return __builtin_ctzll(w);
+#else
+        size_t n = 0;
+        for (; (w & 1U) == 0; w >>= 1U) {
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    std::vector<uint64_t> words_;
+    size_t size_{0};
+};
+
 //! A sparse matrix with efficient access to both rows and columns.
 //!
 //! Insertion into the matrix is linear in the number of rows/columns and
 //! should be avoided.
+//!
+//! The index type determines the maximum number of rows and columns. Using
+//! a narrow type reduces the memory footprint of the matrix.
+template <typename Index = index_t>
 class Tableau {
 private:
-    std::vector<index_t> &reserve_row_(index_t i) {
+    std::vector<Index> &reserve_row_(Index i) {
         if (rows_.size() <= i) {
             rows_.resize(i + 1);
         }
         return rows_[i];
     }
-    std::vector<index_t> &reserve_col_(index_t j) {
+    std::vector<Index> &reserve_col_(Index j) {
         if (cols_.size() <= j) {
             cols_.resize(j + 1);
         }
@@ -86,7 +210,7 @@ private:
 
 public:
     //! Check if the tableau contains row `i` and column `j`.
-    [[nodiscard]] bool contains(index_t i, index_t j) const {
+    [[nodiscard]] bool contains(Index i, Index j) const {
         if (i < rows_.size()) {
             auto const &row = rows_[i];
             auto it = std::lower_bound(row.begin(), row.end(), j);
@@ -98,7 +222,7 @@ public:
     }
 
     //! Set value `a` at row `i` and column `j`.
-    void set(index_t i, index_t j, bool a) {
+    void set(Index i, Index j, bool a) {
         if (a) {
             auto &row = reserve_row_(i);
             auto it = std::lower_bound(row.begin(), row.end(), j);
@@ -126,7 +250,7 @@ public:
 
     //! Traverse non-zero elements in a row.
     template <typename F>
-    void update_row(index_t i, F &&f) {
+    void update_row(Index i, F &&f) {
         if (i < rows_.size()) {
             for (auto &col : rows_[i]) {
                 if (!f(col)) {
@@ -138,7 +262,7 @@ public:
 
     //! Traverse non-zero elements in a column.
     template <typename F>
-    void update_col(index_t j, F &&f) {
+    void update_col(Index j, F &&f) {
         if (j < cols_.size()) {
             auto &col = cols_[j];
             auto it = col.begin();
@@ -159,17 +283,41 @@ public:
         }
     }
 
-    //! Eliminate x_j from rows k != i.
+    //! Remove all elements in column `j` calling `f(i)` for each affected row.
+    template <typename F>
+    void remove_col(Index j, F &&f) {
+        update_col(j, [&](Index i) {
+            auto &row = rows_[i];
+            row.erase(std::lower_bound(row.begin(), row.end(), j));
+            --size_;
+            f(i);
+        });
+        if (j < cols_.size()) {
+            cols_[j].clear();
+        }
+    }
+
+    //! Remove all elements in row `i`.
+    void remove_row(Index i) {
+        if (i < rows_.size()) {
+            size_ -= rows_[i].size();
+            rows_[i].clear();
+        }
+    }
+
+    //! Eliminate x_j from rows k != i calling `f(k)` for each such row.
     //!
     //! This is the only function specific to the simplex algorithm. It is
     //! implemented like this to offer better performance and makes a lot of
     //! assumptions.
-    void eliminate(index_t i, index_t j) {
+    template <typename F>
+    void eliminate(Index i, Index j, F &&f) {
         auto ib = rows_[i].begin();
         auto ie = rows_[i].end();
-        std::vector<index_t> row;
-        update_col(j, [&](index_t k) {
+        std::vector<Index> row;
+        update_col(j, [&](Index k) {
             if (k != i) {
+                f(k);
                 // Note that this call does not invalidate active iterators:
                 // - row i is unaffected because k != i
                 // - there are no insertions in column j because each a_kj != 0
@@ -223,11 +371,343 @@ public:
     }
 
 private:
-    std::vector<std::vector<index_t>> rows_;
-    std::vector<std::vector<index_t>> cols_;
+    std::vector<std::vector<Index>> rows_;
+    std::vector<std::vector<Index>> cols_;
+    size_t size_{0};
+};
+
+//! A dense matrix with a fixed number of columns.
+//!
+//! Each row is stored as an array of `Words` machine words. This offers the
+//! same interface as the sparse tableau above but avoids its indirections
+//! and binary searches for problems with at most `64 * Words` columns.
+//! Traversing a column is linear in the number of rows.
+template <size_t Words>
+class DenseTableau {
+private:
+    using Row = std::array<uint64_t, Words>;
+
+    static constexpr uint64_t bit_(index_t j) {
+        return uint64_t{1} << (j % 64);
+    }
+    [[nodiscard]] static size_t count_(Row const &row) {
+        size_t n = 0;
+        for (auto w : row) {
+            n += popcount_(w);
+        }
+        return n;
+    }
+    [[nodiscard]] static size_t popcount_(uint64_t w) {
+#if defined(__GNUC__)
+        return __builtin_popcountll(w);
+#else
+        size_t n = 0;
+        for (; w != 0; w &= w - 1) {
+            ++n;
+        }
+        return n;
+#endif
+    }
+    [[nodiscard]] static index_t count_trailing_zeros_(uint64_t w) {
+        assert(w != 0);
+#if defined(__GNUC__)
+        return __builtin_ctzll(w);
+#else
+        index_t n = 0;
+        for (; (w & 1U) == 0; w >>= 1U) {
+            ++n;
+        }
+        return n;
+#endif
+    }
+    Row &reserve_row_(index_t i) {
+        if (rows_.size() <= i) {
+            rows_.resize(i + 1, Row{});
+        }
+        return rows_[i];
+    }
+
+public:
+    //! The maximum number of columns.
+    static constexpr size_t columns = 64 * Words;
+
+    //! Check if the tableau contains row `i` and column `j`.
+    [[nodiscard]] bool contains(index_t i, index_t j) const {
+        assert(j < columns);
+        return i < rows_.size() && (rows_[i][j / 64] & bit_(j)) != 0;
+    }
+
+    //! Set value `a` at row `i` and column `j`.
+    void set(index_t i, index_t j, bool a) {
+        assert(j < columns);
+        if (a) {
+            auto &w = reserve_row_(i)[j / 64];
+            if ((w & bit_(j)) == 0) {
+                w |= bit_(j);
+                ++size_;
+            }
+        }
+        else if (contains(i, j)) {
+            rows_[i][j / 64] &= ~bit_(j);
+            --size_;
+        }
+    }
+
+    //! Traverse non-zero elements in a row.
+    template <typename F>
+    void update_row(index_t i, F &&f) {
+        if (i < rows_.size()) {
+            for (index_t k = 0; k != Words; ++k) {
+                for (auto w = rows_[i][k]; w != 0; w &= w - 1) {
+                    if (!f(static_cast<index_t>(64 * k + count_trailing_zeros_(w)))) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    //! Traverse non-zero elements in a column.
+    template <typename F>
+    void update_col(index_t j, F &&f) {
+        for (index_t i = 0, e = static_cast<index_t>(rows_.size()); i != e; ++i) {
+            if ((rows_[i][j / 64] & bit_(j)) != 0) {
+                f(i);
+            }
+        }
+    }
+
+    //! Remove all elements in column `j` calling `f(i)` for each affected row.
+    template <typename F>
+    void remove_col(index_t j, F &&f) {
+        update_col(j, [&](index_t i) {
+            rows_[i][j / 64] &= ~bit_(j);
+            --size_;
+            f(i);
+        });
+    }
+
+    //! Remove all elements in row `i`.
+    void remove_row(index_t i) {
+        if (i < rows_.size()) {
+            size_ -= count_(rows_[i]);
+            rows_[i] = Row{};
+        }
+    }
+
+    //! Eliminate x_j from rows k != i calling `f(k)` for each such row.
+    //!
+    //! Like for the sparse tableau, element `j` is kept in the updated rows.
+    template <typename F>
+    void eliminate(index_t i, index_t j, F &&f) {
+        update_col(j, [&](index_t k) {
+            if (k != i) {
+                f(k);
+                auto &row = rows_[k];
+                size_ -= count_(row);
+                for (index_t w = 0; w != Words; ++w) {
+                    row[w] ^= rows_[i][w];
+                }
+                row[j / 64] |= bit_(j);
+                size_ += count_(row);
+            }
+        });
+    }
+
+    //! Get the number of values in the matrix.
+    [[nodiscard]] size_t size() const {
+        return size_;
+    }
+
+    //! Equivalent to `size() == 0`.
+    [[nodiscard]] bool empty() const {
+        return size_ == 0;
+    }
+
+    //! Clear the tableau.
+    void clear() {
+        size_ = 0;
+        rows_.clear();
+    }
+
+private:
+    std::vector<Row> rows_;
     size_t size_{0};
 };
 
+//! A max-heap of indices ordered by activities that can be bumped.
+//!
+//! Bumping uses an increasing increment so that recent bumps weigh more.
+//! Indices are removed from the heap explicitly and can be added back later.
+class ActivityHeap {
+public:
+    //! Resize the heap to hold indices in range `[0, n)`.
+    //!
+    //! New indices have zero activity and are not in the heap.
+    void resize(index_t n) {
+        activity_.resize(n, 0);
+        positions_.resize(n, none);
+    }
+
+    //! Check if index `i` is in the heap.
+    [[nodiscard]] bool contains(index_t i) const {
+        return positions_[i] != none;
+    }
+
+    //! Check if the heap is empty.
+    [[nodiscard]] bool empty() const {
+        return heap_.empty();
+    }
+
+    //! Get the activity of index `i`.
+    [[nodiscard]] double activity(index_t i) const {
+        return activity_[i];
+    }
+
+    //! Get the index with the highest activity.
+    [[nodiscard]] index_t top() const {
+        assert(!empty());
+        return heap_.front();
+    }
+
+    //! Add index `i` to the heap if it is not already contained.
+    void push(index_t i) {
+        if (!contains(i)) {
+            positions_[i] = static_cast<index_t>(heap_.size());
+            heap_.emplace_back(i);
+            up_(positions_[i]);
+        }
+    }
+
+    //! Remove the index with the highest activity.
+    void pop() {
+        assert(!empty());
+        positions_[heap_.front()] = none;
+        if (heap_.size() > 1) {
+            heap_.front() = heap_.back();
+            positions_[heap_.front()] = 0;
+            heap_.pop_back();
+            down_(0);
+        }
+        else {
+            heap_.pop_back();
+        }
+    }
+
+    //! Increase the activity of index `i`.
+    void bump(index_t i) {
+        activity_[i] += increment_;
+        if (activity_[i] > limit) {
+            for (auto &a : activity_) {
+                a /= limit;
+            }
+            increment_ /= limit;
+        }
+        if (contains(i)) {
+            up_(positions_[i]);
+        }
+    }
+
+    //! Make future bumps weigh more than previous ones.
+    void decay() {
+        increment_ /= decay_factor;
+    }
+
+private:
+    static constexpr index_t none = std::numeric_limits<index_t>::max();
+    static constexpr double limit = 1e100;
+    static constexpr double decay_factor = 0.95;
+
+    void up_(index_t k) {
+        auto i = heap_[k];
+        while (k > 0) {
+            auto p = (k - 1) / 2;
+            if (activity_[heap_[p]] >= activity_[i]) {
+                break;
+            }
+            heap_[k] = heap_[p];
+            positions_[heap_[k]] = k;
+            k = p;
+        }
+        heap_[k] = i;
+        positions_[i] = k;
+    }
+
+    void down_(index_t k) {
+        auto i = heap_[k];
+        auto n = static_cast<index_t>(heap_.size());
+        while (2 * k + 1 < n) {
+            auto c = 2 * k + 1;
+            if (c + 1 < n && activity_[heap_[c + 1]] > activity_[heap_[c]]) {
+                ++c;
+            }
+            if (activity_[heap_[c]] <= activity_[i]) {
+                break;
+            }
+            heap_[k] = heap_[c];
+            positions_[heap_[k]] = k;
+            k = c;
+        }
+        heap_[k] = i;
+        positions_[i] = k;
+    }
+
+    std::vector<double> activity_;
+    std::vector<index_t> positions_;
+    std::vector<index_t> heap_;
+    double increment_{1};
+};
+
+//! Call `f(i)` for each `i` in `[0, n)` using up to `n_threads` threads.
+//!
+//! Indices are handed out in small chunks to balance uneven work. The calling
+//! thread participates in the work. The first exception thrown by `f` stops
+//! the remaining work and is rethrown in the calling thread.
+template <typename F>
+void parallel_for(size_t n, size_t n_threads, F &&f) {
+    constexpr size_t chunk = 16;
+    n_threads = std::min(n_threads, (n + chunk - 1) / chunk);
+    if (n_threads <= 1) {
+        for (size_t i = 0; i < n; ++i) {
+            f(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr exc;
+    std::mutex mut;
+    auto worker = [&]() {
+        try {
+            for (size_t i = next.fetch_add(chunk); i < n; i = next.fetch_add(chunk)) {
+                for (size_t j = i, e = std::min(i + chunk, n); j < e; ++j) {
+                    f(j);
+                }
+            }
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock{mut};
+            if (!exc) {
+                exc = std::current_exception();
+            }
+            next = n;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n_threads - 1);
+    for (size_t t = 1; t < n_threads; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (exc) {
+        std::rethrow_exception(exc);
+    }
+}
+
 class Timer {
 private:
     using Clock = std::chrono::steady_clock;
@@ -0,0 +1,204 @@
+#include "watched.hh"
+
+WatchedSolver::WatchedSolver(XORStore const &constraints)
+: constraints_{constraints} {
+}
+
+Clingo::Span<index_t> WatchedSolver::columns_(index_t i) const {
+    return {elements_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]}; // NOLINT
+}
+
+bool WatchedSolver::assigned_(Clingo::Assignment ass, index_t j) const {
+    if (j < n_variables_) {
+        auto lit = constraints_.variable(j);
+        return ass.is_true(lit) || ass.is_false(lit);
+    }
+    return ass.is_true(constraints_[rows_[j - n_variables_]].lit);
+}
+
+index_t WatchedSolver::find_unassigned_(Clingo::Assignment ass, index_t i) const {
+    auto [a, b] = watched_[i];
+    for (auto j : columns_(i)) {
+        if (j != a && j != b && !assigned_(ass, j)) {
+            return j;
+        }
+    }
+    return none;
+}
+
+template <class A>
+bool WatchedSolver::propagate_(A &ctl, index_t i, index_t j) {
+    auto ass = ctl.assignment();
+    auto x = constraints_[rows_[i]];
+    Value sum;
+    clause_.clear();
+    for (auto k : columns_(i)) {
+        if (k == j) {
+            continue;
+        }
+        if (k < n_variables_) {
+            auto lit = constraints_.variable(k);
+            if (ass.is_true(lit)) {
+                sum ^= Value{true};
+                clause_.emplace_back(-lit);
+            }
+            else {
+                clause_.emplace_back(lit);
+            }
+        }
+        else {
+            sum ^= x.rhs;
+            clause_.emplace_back(-x.lit);
+        }
+    }
+
+    // the constraint is conflicting or satisfied
+    if (j == none) {
+        if (!sum) {
+            return true;
+        }
+        ++conflicts_;
+        return ctl.add_clause(clause_);
+    }
+
+    // the constraint is unit
+    if (j < n_variables_) {
+        auto lit = constraints_.variable(j);
+        clause_.emplace_back(sum ? lit : -lit);
+    }
+    else {
+        // Note: Nothing can be derived if the value of the slack column
+        // agrees with the right-hand side because the constraint only has to
+        // hold if its literal is true.
+        if (sum == x.rhs) {
+            return true;
+        }
+        clause_.emplace_back(-x.lit);
+    }
+    if (ass.is_true(clause_.back())) {
+        return true;
+    }
+    ++propagations_;
+    return ctl.add_clause(clause_);
+}
+
+bool WatchedSolver::prepare(Clingo::PropagateInit &init) {
+    auto ass = init.assignment();
+    n_variables_ = static_cast<index_t>(constraints_.n_variables());
+
+    // gather the columns of the constraints
+    std::vector<index_t> lhs;
+    std::vector<bool> occurs(n_variables_, false);
+    offsets_.emplace_back(0);
+    for (size_t k = 0, e = constraints_.size(); k != e; ++k) {
+        auto x = constraints_[k];
+        if (ass.is_false(x.lit)) {
+            continue;
+        }
+        lhs.assign(x.lhs.begin(), x.lhs.end());
+        std::sort(lhs.begin(), lhs.end());
+        // remove pairs of equal variables
+        auto it = lhs.begin();
+        for (auto jt = lhs.begin(), je = lhs.end(); jt != je; ) {
+            auto kt = std::find_if(jt, je, [&](index_t j) { return j != *jt; });
+            if ((kt - jt) % 2 == 1) {
+                *it++ = *jt;
+            }
+            jt = kt;
+        }
+        lhs.erase(it, lhs.end());
+        // check bound against 0
+        if (lhs.empty()) {
+            if (x.rhs && !init.add_clause({-x.lit})) {
+                return false;
+            }
+            continue;
+        }
+        auto i = static_cast<index_t>(rows_.size());
+        rows_.emplace_back(k);
+        for (auto j : lhs) {
+            occurs[j] = true;
+        }
+        elements_.insert(elements_.end(), lhs.begin(), lhs.end());
+        elements_.emplace_back(n_variables_ + i);
+        offsets_.emplace_back(elements_.size());
+        lit_columns_.emplace(x.lit, n_variables_ + i);
+    }
+    for (index_t j = 0; j != n_variables_; ++j) {
+        if (occurs[j]) {
+            auto lit = constraints_.variable(j);
+            lit_columns_.emplace(lit, j);
+            lit_columns_.emplace(-lit, j);
+        }
+    }
+
+    // watch two unassigned columns if possible
+    auto n_rows = static_cast<index_t>(rows_.size());
+    watches_.resize(n_variables_ + n_rows);
+    watched_.resize(n_rows, {none, none});
+    for (index_t i = 0; i != n_rows; ++i) {
+        auto columns = columns_(i);
+        auto &[a, b] = watched_[i];
+        a = find_unassigned_(ass, i);
+        b = a == none ? none : find_unassigned_(ass, i);
+        if (b == none && !propagate_(init, i, a)) {
+            return false;
+        }
+        // Note: The constraint has been propagated above if there are less
+        // than two unassigned columns. The remaining watches are filled with
+        // arbitrary columns.
+        for (auto j : columns) {
+            if (a == none) {
+                a = j;
+            }
+            else if (b == none && j != a) {
+                b = j;
+            }
+        }
+        watches_[a].emplace_back(i);
+        watches_[b].emplace_back(i);
+    }
+
+    return true;
+}
+
+bool WatchedSolver::update_(Clingo::PropagateControl &ctl, index_t i, index_t j) {
+    auto ass = ctl.assignment();
+    auto &[a, b] = watched_[i];
+    auto k = find_unassigned_(ass, i);
+    if (k != none) {
+        (a == j ? a : b) = k;
+        watches_[k].emplace_back(i);
+        return true;
+    }
+    auto other = a == j ? b : a;
+    return propagate_(ctl, i, assigned_(ass, other) ? none : other);
+}
+
+bool WatchedSolver::solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits) {
+    for (auto lit : lits) {
+        for (auto [it, ie] = lit_columns_.equal_range(lit); it != ie; ++it) {
+            auto j = it->second;
+            auto &watches = watches_[j];
+            auto jt = watches.begin();
+            bool ret = true;
+            for (auto kt = watches.begin(), ke = watches.end(); kt != ke; ++kt) {
+                auto i = *kt;
+                ret = update_(ctl, i, j);
+                auto [a, b] = watched_[i];
+                if (a == j || b == j) {
+                    *jt++ = i;
+                }
+                if (!ret) {
+                    jt = std::copy(kt + 1, ke, jt);
+                    break;
+                }
+            }
+            watches.erase(jt, watches.end());
+            if (!ret) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
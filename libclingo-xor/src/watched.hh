@@ -0,0 +1,81 @@
+#pragma once
+
+#include "problem.hh"
+
+#include <unordered_map>
+
+//! A propagator for short XOR constraints based on two watched columns.
+//!
+//! Each constraint `lhs = rhs :- lit` has the variables in `lhs` and a slack
+//! column as columns. The slack column is assigned `rhs` if `lit` is true.
+//! Two unassigned columns of each constraint are watched. Once a watched
+//! column is assigned, another unassigned column is searched. If there is
+//! none, the constraint is unit or conflicting.
+//!
+//! Values are read directly from the solver's assignment. Hence, there is
+//! no trail and nothing has to be undone when backtracking. Memory is linear
+//! in the total length of the constraints.
+class WatchedSolver {
+private:
+    //! Marker for missing columns.
+    static constexpr index_t none = std::numeric_limits<index_t>::max();
+
+public:
+    //! Construct a new solver object.
+    WatchedSolver(XORStore const &constraints);
+
+    //! Set up the watches.
+    [[nodiscard]] bool prepare(Clingo::PropagateInit &init);
+    //! Propagate the constraints watching the given literals.
+    //!
+    //! If the function returns false, the solver has to backtrack.
+    [[nodiscard]] bool solve(Clingo::PropagateControl &ctl, Clingo::LiteralSpan lits);
+
+    //! Get the number of propagated literals.
+    [[nodiscard]] size_t propagations() const {
+        return propagations_;
+    }
+    //! Get the number of conflicts.
+    [[nodiscard]] size_t conflicts() const {
+        return conflicts_;
+    }
+
+private:
+    //! Get the columns of constraint `i`.
+    [[nodiscard]] Clingo::Span<index_t> columns_(index_t i) const;
+    //! Check if column `j` is assigned.
+    [[nodiscard]] bool assigned_(Clingo::Assignment ass, index_t j) const;
+    //! Find an unassigned column of constraint `i` different from the
+    //! watched columns.
+    [[nodiscard]] index_t find_unassigned_(Clingo::Assignment ass, index_t i) const;
+    //! Add the clause for constraint `i` if it is unit or conflicting.
+    //!
+    //! Column `j` is the only column that might be unassigned.
+    template <class A>
+    [[nodiscard]] bool propagate_(A &ctl, index_t i, index_t j);
+    //! Update constraint `i` after its watched column `j` has been assigned.
+    [[nodiscard]] bool update_(Clingo::PropagateControl &ctl, index_t i, index_t j);
+
+    //! The XOR constraints.
+    XORStore const &constraints_;
+    //! The constraints handled by the solver.
+    std::vector<index_t> rows_;
+    //! The columns of the constraints.
+    std::vector<index_t> elements_;
+    //! Offsets into the elements for each constraint.
+    std::vector<index_t> offsets_;
+    //! The two watched columns of each constraint.
+    std::vector<std::pair<index_t, index_t>> watched_;
+    //! The constraints watching a column.
+    std::vector<std::vector<index_t>> watches_;
+    //! Map from literals to the columns they assign.
+    std::unordered_multimap<Clingo::literal_t, index_t> lit_columns_;
+    //! The clause to add.
+    std::vector<Clingo::literal_t> clause_;
+    //! The number of variable columns.
+    index_t n_variables_{0};
+    //! The number of propagated literals.
+    size_t propagations_{0};
+    //! The number of conflicts.
+    size_t conflicts_{0};
+};
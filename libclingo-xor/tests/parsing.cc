@@ -8,15 +8,17 @@ namespace {
 struct TestPropagator : public Clingo::Propagator {
     void init(Clingo::PropagateInit &init) override {
         VarMap vars;
-        evaluate_theory(init, vars, eqs);
+        evaluate_theory(init, vars, eqs, config);
     }
-    std::vector<XORConstraint> eqs;
+    Config config;
+    XORStore eqs;
 };
 
 using S = std::vector<std::string>;
 
-S evaluate(char const *prg) {
+S evaluate(char const *prg, Config const &config = Config{}) {
     TestPropagator prp;
+    prp.config = config;
     Clingo::Control ctl;
     ctl.register_propagator(prp);
     ctl.add("base", {}, THEORY);
@@ -24,7 +26,8 @@ S evaluate(char const *prg) {
     ctl.ground({{"base", {}}});
     ctl.solve(Clingo::LiteralSpan{}, nullptr, false, false).get();
     S ret;
-    for (auto &eq : prp.eqs) {
+    for (size_t i = 0, e = prp.eqs.size(); i != e; ++i) {
+        auto eq = prp.eqs[i];
         std::ostringstream ss;
         eq.lit = eq.lit > 0 ? 1 : -1;
         ss << eq;
@@ -42,18 +45,28 @@ TEST_CASE("parsing") {
     REQUIRE(evaluate("{x}. &odd  { x: x }.").empty());
 
     REQUIRE(evaluate("{x; y}. &even { x: x; y: y }.") == S{
-        "var_0 = 0 :- not lit_1",       // x = 0
-        "var_0 = 1 :- lit_1",           // x = 1
-        "var_1 = 0 :- not lit_1",       // y = 0
-        "var_1 = 1 :- lit_1",           // y = 1
         "var_0 + var_1 = 0 :- lit_1"}); // x + y = 0
 
     REQUIRE(evaluate("{x; y; z}. &even { x: x; yz: y; yz: z }.") == S{
-        "var_0 = 0 :- not lit_1",       // x  = 0
-        "var_0 = 1 :- lit_1",           // x  = 1
-        "var_1 = 0 :- not lit_1",       // yz = 0
-        "var_1 = 1 :- lit_1",           // yz = 1
-        "var_0 + var_1 = 0 :- lit_1"}); // x + y = 0
+        "var_0 + var_1 = 0 :- lit_1"}); // x + yz = 0
+
+    Config config;
+    config.translate = 2;
+    REQUIRE(evaluate("{x; y}. &even { x: x; y: y }.", config).empty());
+    REQUIRE(evaluate("{x; y; z}. &even { x: x; y: y; z: z }.", config) == S{
+        "var_0 + var_1 + var_2 = 0 :- lit_1"});
+
+    // cutting into chains
+    config.translate = 0;
+    config.cut = 3;
+    REQUIRE(evaluate("{x; y; z}. &even { x: x; y: y; z: z }.", config) == S{
+        "var_0 + var_1 + var_2 = 0 :- lit_1"});
+    REQUIRE(evaluate("{w; x; y; z}. &odd { w: w; x: x; y: y; z: z }.", config) == S{
+        "var_0 + var_1 + var_2 = 0 :- lit_1",  // a = w + x
+        "var_2 + var_3 + var_4 = 1 :- lit_1"}); // a + y + z = 1
 
+    // cutting and translating
+    config.translate = 3;
+    REQUIRE(evaluate("{w; x; y; z}. &odd { w: w; x: x; y: y; z: z }.", config).empty());
 };
 
@@ -0,0 +1,135 @@
+#include "../src/preprocessing.hh"
+#include "../src/parsing.hh"
+#include "catch.hpp"
+
+#include <sstream>
+
+namespace {
+
+struct TestPropagator : public Clingo::Propagator {
+    void init(Clingo::PropagateInit &init) override {
+        VarMap vars;
+        evaluate_theory(init, vars, eqs, config);
+        sat = substitute_equivalences(init, eqs, classes, stats);
+        if (sat && eliminate) {
+            eliminate_variables(init, eqs, eliminated, stats);
+        }
+    }
+    XORStore eqs;
+    XORStore eliminated;
+    EquivalenceClasses classes;
+    PreprocessingStatistics stats;
+    Config config;
+    bool eliminate{false};
+    bool sat{true};
+};
+
+using S = std::vector<std::string>;
+
+S to_strings(XORStore const &eqs) {
+    S ret;
+    for (size_t i = 0, e = eqs.size(); i != e; ++i) {
+        auto eq = eqs[i];
+        std::ostringstream ss;
+        eq.lit = eq.lit > 0 ? 1 : -1;
+        ss << eq;
+        ret.emplace_back(ss.str());
+    }
+    return ret;
+}
+
+void run(TestPropagator &prp, char const *prg) {
+    Clingo::Control ctl;
+    ctl.register_propagator(prp);
+    ctl.add("base", {}, THEORY);
+    ctl.add("base", {}, prg);
+    ctl.ground({{"base", {}}});
+    ctl.solve(Clingo::LiteralSpan{}, nullptr, false, false).get();
+    REQUIRE(prp.sat);
+}
+
+S substitute(char const *prg, size_t equivalences) {
+    TestPropagator prp;
+    run(prp, prg);
+    REQUIRE(prp.stats.equivalences == equivalences);
+    return to_strings(prp.eqs);
+}
+
+std::pair<S, S> eliminate(char const *prg, size_t merged, size_t eliminated, Config const &config = Config{}) {
+    TestPropagator prp;
+    prp.config = config;
+    prp.eliminate = true;
+    run(prp, prg);
+    REQUIRE(prp.stats.merged_rows == merged);
+    REQUIRE(prp.stats.eliminated_rows == eliminated);
+    return {to_strings(prp.eqs), to_strings(prp.eliminated)};
+}
+
+} // namespace
+
+TEST_CASE("preprocessing") {
+    SECTION("classes") {
+        EquivalenceClasses c;
+        c.resize(4);
+        REQUIRE(c.size() == 4);
+        REQUIRE(c.find(1) == std::pair{index_t{1}, Value{false}});
+
+        // x_1 = x_0 + 1
+        c.merge(1, 0, Value{true});
+        REQUIRE(c.find(1) == std::pair{index_t{0}, Value{true}});
+
+        // x_3 = x_2
+        c.merge(2, 3, Value{false});
+        REQUIRE(c.find(3) == std::pair{index_t{2}, Value{false}});
+
+        // x_2 = x_0 + 1
+        c.merge(0, 2, Value{true});
+        REQUIRE(c.find(3) == std::pair{index_t{0}, Value{true}});
+        REQUIRE(c.find(2) == std::pair{index_t{0}, Value{true}});
+        REQUIRE(c.find(0) == std::pair{index_t{0}, Value{false}});
+    }
+    SECTION("substitute") {
+        // conditional binary constraints are kept
+        REQUIRE(substitute("{x; y; c}. &even { x: x; y: y } :- c.", 0) == S{
+            "var_0 + var_1 = 0 :- lit_1"});
+
+        // x = y and the remaining constraint z = 1 becomes a clause
+        REQUIRE(substitute("{x; y; z}. &even { x: x; y: y }. &odd { x: x; y: y; z: z }.", 1) == S{});
+
+        // x = y + 1 and the remaining constraint z = 1 becomes a clause
+        REQUIRE(substitute("{x; y; z}. &odd { x: x; y: y }. &even { x: x; y: y; z: z }.", 1) == S{});
+
+        // x = y and the remaining constraints have at least two variables
+        REQUIRE(substitute("{w; x; y; z}. &even { x: x; y: y }. &odd { w: w; x: x; y: y; z: z }.", 1) == S{
+            "var_2 + var_3 = 1 :- lit_1"});
+    }
+    SECTION("eliminate") {
+        // program atoms are never eliminated
+        REQUIRE(eliminate("{w; x; y; z}. &odd { w: w; x: x; y: y }. &even { x: x; y: y; z: z }.", 0, 0) == std::pair{
+            S{"var_0 + var_1 + var_2 = 1 :- lit_1", "var_1 + var_2 + var_3 = 0 :- lit_1"},
+            S{}});
+
+        // the second constraint is replaced by the sum of both
+        REQUIRE(eliminate("{v; w; x; y; z}. &odd { w: w; x: x; y: y }. &even { v: v; w: w; x: x; y: y; z: z }.", 1, 0) == std::pair{
+            S{"var_0 + var_1 + var_2 = 1 :- lit_1", "var_3 + var_4 = 1 :- lit_1"},
+            S{}});
+
+        // sums with fewer than two variables are not used
+        REQUIRE(eliminate("{w; x; y; z}. &odd { w: w; x: x; y: y }. &even { w: w; x: x; y: y; z: z }.", 0, 0) == std::pair{
+            S{"var_0 + var_1 + var_2 = 1 :- lit_1", "var_0 + var_1 + var_2 + var_3 = 0 :- lit_1"},
+            S{}});
+
+        // the auxiliary variable of the cut only occurs in the first piece
+        // because the literal of the second one is false
+        Config config;
+        config.cut = 3;
+        auto res = eliminate("{w; x; y; z; c}. :- c. &odd { w: w; x: x; y: y; z: z } :- c.", 0, 1, config);
+        REQUIRE(res.first.size() == 1);
+        REQUIRE(res.second == S{"var_0 + var_1 + var_2 = 0 :- lit_1"});
+
+        // conditional constraints are kept
+        REQUIRE(eliminate("{x; y; z; c}. &odd { x: x; y: y; z: z } :- c.", 0, 0) == std::pair{
+            S{"var_0 + var_1 + var_2 = 1 :- lit_1"},
+            S{}});
+    }
+};
@@ -3,12 +3,17 @@
 
 #include <catch.hpp>
 
+#include <map>
 #include <sstream>
 
 namespace {
 
 using S = std::vector<std::vector<std::string>>;
 using SV = std::vector<S>;
+//! Statistics of the first thread by name.
+//!
+//! Names of nested statistics are separated by slashes.
+using Stats = std::map<std::string, double>;
 
 struct ModelHandler : Clingo::SolveEventHandler {
     ModelHandler(Propagator &prp)
@@ -24,14 +29,33 @@ struct ModelHandler : Clingo::SolveEventHandler {
         }
         return true;
     }
+    void on_statistics(Clingo::UserStatistics step, Clingo::UserStatistics accu) override {
+        prp.on_statistics(step, accu);
+        auto thread = accu["Simplex"]["Threads"][size_t{0}];
+        for (auto &[name, value] : stats) {
+            auto stat = thread;
+            std::istringstream ss{name};
+            for (std::string key; std::getline(ss, key, '/'); ) {
+                stat = stat[key.c_str()];
+            }
+            value = stat.value();
+        }
+    }
     Propagator &prp;
     S res;
+    Stats stats;
 };
 
-SV run_m(std::initializer_list<char const *> m) {
-    Propagator prp{true};
+//! Solve the given programs one after the other.
+//!
+//! If given, the values of the statistics in the map are updated.
+SV run_m(std::initializer_list<char const *> m, Config const &config = Config{}, Stats *stats = nullptr) {
+    Propagator prp{config};
     ModelHandler hnd{prp};
-    Clingo::Control ctl{{"0"}};
+    if (stats != nullptr) {
+        hnd.stats = *stats;
+    }
+    Clingo::Control ctl{{"0", "--stats"}};
     prp.register_control(ctl);
     SV res;
 
@@ -46,11 +70,133 @@ SV run_m(std::initializer_list<char const *> m) {
         std::sort(hnd.res.begin(), hnd.res.end());
         std::swap(res.back(), hnd.res);
     }
+    if (stats != nullptr) {
+        *stats = hnd.stats;
+    }
     return res;
 }
 
-S run(char const *s) {
-    return run_m({s}).front();
+S run(char const *s, Config const &config = Config{}, Stats *stats = nullptr) {
+    return run_m({s}, config, stats).front();
+}
+
+//! A propagator driving a simplex-based solver directly.
+//!
+//! The propagator first decides the given variables to be false. The values
+//! of the solver are recorded after solving on each decision level and
+//! checked against the decisions. When reaching decision level
+//! `undo_level + 1`, all levels down to `undo_level` are undone at once and
+//! the solver is not used anymore.
+struct SolverPropagator : Clingo::Propagator {
+    SolverPropagator(std::vector<index_t> decisions, index_t undo_level = 0)
+    : decisions{std::move(decisions)}
+    , undo_level{undo_level} { }
+    void init(Clingo::PropagateInit &init) override {
+        VarMap vars;
+        evaluate_theory(init, vars, iqs, config);
+        slv = std::make_unique<Solver<true, uint32_t>>(iqs, config);
+        if (!slv->prepare(init)) {
+            return;
+        }
+        for (index_t i = 0, e = iqs.n_variables(); i != e; ++i) {
+            init.add_watch(iqs.variable(i));
+            init.add_watch(-iqs.variable(i));
+        }
+        for (size_t k = 0, e = iqs.size(); k != e; ++k) {
+            init.add_watch(iqs[k].lit);
+        }
+    }
+    void propagate(Clingo::PropagateControl &ctl, Clingo::LiteralSpan changes) override {
+        if (done) {
+            return;
+        }
+        auto ass = ctl.assignment();
+        auto level = ass.decision_level();
+        if (!slv->solve(ctl, changes)) {
+            return;
+        }
+        auto &vals = values[level];
+        vals.clear();
+        for (index_t i = 0, e = iqs.n_variables(); i != e; ++i) {
+            vals.emplace_back(static_cast<bool>(slv->get_value(i)));
+        }
+        for (auto var : decisions) {
+            if (ass.is_false(iqs.variable(var)) && vals[var]) {
+                violated = true;
+            }
+        }
+        if (undo_level > 0 && level == undo_level + 1) {
+            done = true;
+            slv->undo(undo_level);
+            for (index_t i = 0, e = iqs.n_variables(); i != e; ++i) {
+                restored.emplace_back(static_cast<bool>(slv->get_value(i)));
+            }
+            // the bound of the decision on the undone level has been removed
+            resolved = slv->solve(ctl, {iqs.variable(decisions[undo_level - 1])});
+        }
+    }
+    void undo(Clingo::PropagateControl const &ctl, Clingo::LiteralSpan changes) noexcept override {
+        static_cast<void>(changes);
+        if (!done) {
+            slv->undo(ctl.assignment().decision_level());
+        }
+    }
+    void check(Clingo::PropagateControl &ctl) override {
+        if (!done && ctl.assignment().is_total()) {
+            static_cast<void>(slv->finish(ctl));
+        }
+    }
+    Clingo::literal_t decide(Clingo::id_t thread_id, Clingo::Assignment const &ass, Clingo::literal_t fallback) override {
+        static_cast<void>(thread_id);
+        for (auto var : decisions) {
+            auto lit = iqs.variable(var);
+            if (!ass.is_true(lit) && !ass.is_false(lit)) {
+                return -lit;
+            }
+        }
+        return fallback;
+    }
+    Config config;
+    XORStore iqs;
+    std::unique_ptr<Solver<true, uint32_t>> slv;
+    std::vector<index_t> decisions;
+    index_t undo_level;
+    std::map<index_t, std::vector<bool>> values;
+    std::vector<bool> restored;
+    bool violated{false};
+    bool resolved{false};
+    bool done{false};
+};
+
+//! Solve the given program with the given propagator and count its models.
+size_t run_solver(SolverPropagator &prp, char const *s) {
+    Clingo::Control ctl{{"0"}};
+    ctl.register_propagator(prp);
+    ctl.add("base", {}, THEORY);
+    ctl.add("base", {}, s);
+    ctl.ground({{"base", {}}});
+    size_t n = 0;
+    for (auto const &model : ctl.solve()) {
+        static_cast<void>(model);
+        ++n;
+    }
+    return n;
+}
+
+//! Variables x(1..10) with odd parity in all windows of four consecutive
+//! variables.
+char const *const WINDOWS = "{ x(1..10) }.\n"
+                            "&odd { X: x(X), Y <= X, X < Y+4 } :- Y = 1..7.\n";
+
+//! Solve the windows with a solver deciding all variables to be false in
+//! the order of their indices.
+//!
+//! Returns the number of models and the statistics of the solver.
+std::pair<size_t, Statistics> run_windows(Config const &config) {
+    SolverPropagator prp{{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}};
+    prp.config = config;
+    auto n = run_solver(prp, WINDOWS);
+    return {n, prp.slv->statistics()};
 }
 
 } // namespace
@@ -74,6 +220,247 @@ TEST_CASE("solving") {
                     "&even { x:x; y:y }.\n"
                     "&odd  {      y:y }.\n"
                     "&odd  { x:x      }.\n") == S{{"x", "y"}});
+
+        REQUIRE(run("{x}.\n"
+                    "&odd { a; a:x }.\n") == S{{}, {"x"}});
+
+        REQUIRE(run("{x; y; c}.\n"
+                    "&odd { x:x; y:y } :- c.\n") == S{
+                        {}, {"c", "x"}, {"c", "y"}, {"x"}, {"x", "y"}, {"y"}});
+    }
+    SECTION("many-atoms") {
+        REQUIRE(run("{ p(1..2,1..70) }.\n"
+                    "&odd { X: p(X,Y) } :- Y = 1..70.\n"
+                    ":- p(1,Y).\n"
+                    "#show.\n") == S{{}});
+
+        Config config;
+        config.parse_threads = 1;
+        REQUIRE(run("{ p(1..2,1..70) }.\n"
+                    "&odd { X: p(X,Y) } :- Y = 1..70.\n"
+                    ":- p(1,Y).\n"
+                    "#show.\n", config) == S{{}});
+    }
+    SECTION("refactor") {
+        Config config;
+        config.refactor = 1;
+        REQUIRE(run(WINDOWS, config) == run(WINDOWS));
+
+        // without a factor, the tableau is only refactored on level 0
+        auto [n, stats] = run_windows(config);
+        auto [n_base, stats_base] = run_windows(Config{});
+        REQUIRE(n == 8);
+        REQUIRE(n_base == 8);
+        REQUIRE(stats.refactors > stats_base.refactors);
+    }
+    SECTION("revert") {
+        Config config;
+        config.revert = 1;
+        REQUIRE(run(WINDOWS, config) == run(WINDOWS));
+
+        auto [n, stats] = run_windows(config);
+        REQUIRE(n == 8);
+        REQUIRE(stats.reverted > 0);
+
+        config.pivot_budget = 1;
+        REQUIRE(run(WINDOWS, config) == run(WINDOWS));
+    }
+    SECTION("undo-levels") {
+        // Solving on levels 1 to 3 assigns x(3) on levels 2 and 3. Undoing
+        // both levels at once has to restore the value from level 1.
+        SolverPropagator prp{{0, 1, 2}, 2};
+        run_solver(prp, "{ x(1..4) }.\n"
+                        "&odd { X: x(X) }.\n");
+        REQUIRE(prp.done);
+        REQUIRE(!prp.violated);
+        REQUIRE(prp.values.count(1) == 1);
+        REQUIRE(prp.values.count(3) == 1);
+        REQUIRE(prp.values[1] != prp.values[3]);
+        REQUIRE(prp.restored == prp.values[1]);
+        REQUIRE(prp.resolved);
+    }
+    SECTION("cached-candidates") {
+        // Conflicts on the same row on levels 2 and 6 reuse candidates of
+        // earlier scans. On level 5, the decisions on levels 3 and 4 have
+        // exhausted the cached candidates and the row is scanned again. The
+        // decided variables keep their values throughout.
+        SolverPropagator prp{{0, 1, 3, 4, 2, 5}};
+        REQUIRE(run_solver(prp, "{ x(1..8) }.\n"
+                                "&odd { X: x(X) }.\n") == 128);
+        REQUIRE(!prp.violated);
+        REQUIRE(prp.slv->statistics().cached_candidates >= 2);
+    }
+    SECTION("gauss-jordan") {
+        Config config;
+        config.engine = Engine::GaussJordan;
+        REQUIRE(run("{x; y; z}.\n"
+                    "&even { x:x; y:y }.\n"
+                    "&odd  { x:x; z:z }.\n", config) == S{{"x", "y"}, {"z"}});
+
+        REQUIRE(run("{x; y}.\n"
+                    "&odd  { x:x; y:y }.\n"
+                    "&even { x:x; y:y }.\n"
+                    "&even {      y:y }.\n", config).empty());
+
+        REQUIRE(run("{x; y; c}.\n"
+                    "&odd { x:x; y:y } :- c.\n", config) == S{
+                        {}, {"c", "x"}, {"c", "y"}, {"x"}, {"x", "y"}, {"y"}});
+
+        REQUIRE(run("{ x(1..6) }.\n"
+                    "&odd { X: x(X), X <= Y } :- Y = 1..6.\n", config) == S{{"x(1)"}});
+
+        REQUIRE(run_m({"{x; y; z}.\n"
+                        "&even { x:x; y:y }.\n"
+                        "&odd  { z:z }.\n",
+                        "&odd  { x:x }.\n",
+                        "&even { y:y }.\n"}, config) == SV{
+                      {{"x","y","z"}, {"z"}},
+                      {{"x", "y", "z"}}, {}});
+    }
+    SECTION("watched") {
+        Config config;
+        config.watched_length = 2;
+        REQUIRE(run("{x; y; z}.\n"
+                    "&even { x:x; y:y }.\n"
+                    "&odd  { x:x; z:z }.\n", config) == S{{"x", "y"}, {"z"}});
+
+        REQUIRE(run("{x; y; c}.\n"
+                    "&odd { x:x; y:y } :- c.\n", config) == S{
+                        {}, {"c", "x"}, {"c", "y"}, {"x"}, {"x", "y"}, {"y"}});
+
+        // short constraints are watched and long ones are kept in the tableau
+        REQUIRE(run("{ x(1..6) }.\n"
+                    "&odd { X: x(X), X <= Y } :- Y = 1..6.\n", config) == S{{"x(1)"}});
+
+        config.engine = Engine::GaussJordan;
+        REQUIRE(run("{ x(1..6) }.\n"
+                    "&odd { X: x(X), X <= Y } :- Y = 1..6.\n", config) == S{{"x(1)"}});
+    }
+    SECTION("propagate-binary") {
+        Config config;
+        config.propagate_binary = true;
+        config.equivalences = false;
+        config.eliminate = false;
+        REQUIRE(run("{x; y; z}.\n"
+                    "&even { x:x; y:y }.\n"
+                    "&odd  { x:x; z:z }.\n", config) == S{{"x", "y"}, {"z"}});
+
+        REQUIRE(run("{ x(1..6) }.\n"
+                    "&odd { X: x(X), X <= Y } :- Y = 1..6.\n", config) == S{{"x(1)"}});
+
+        // x = y is derived once z is fixed
+        Stats stats{{"Derived Equivalences", 0}};
+        REQUIRE(run("{x; y; z; c}.\n"
+                    "&odd { x:x; y:y; z:z } :- c.\n"
+                    ":- not c.\n"
+                    ":- not z.\n", config, &stats) == S{{"c", "x", "y", "z"}, {"c", "z"}});
+        REQUIRE(stats["Derived Equivalences"] > 0);
+
+        // equivalences are derived again if their clauses are not kept
+        for (auto type : {Clingo::ClauseType::Static, Clingo::ClauseType::Volatile}) {
+            config.clause_type = type;
+            config.reason_length = 2;
+            REQUIRE(run(WINDOWS, config) == run(WINDOWS));
+        }
+    }
+    SECTION("shortest-conflict") {
+        Config config;
+        config.shortest_conflict = true;
+        config.propagate = false;
+        REQUIRE(run("{x; y}.\n"
+                    "&odd  { x:x; y:y }.\n"
+                    "&even { x:x; y:y }.\n"
+                    "&even {      y:y }.\n", config).empty());
+
+        REQUIRE(run("{ x(1..6) }.\n"
+                    "&odd { X: x(X), X <= Y } :- Y = 1..6.\n", config) == S{{"x(1)"}});
+
+        // Note: On total assignments, overlapping windows give conflicting
+        // rows that can be shortened by adding a satisfied row.
+        config.propagate = true;
+        config.check_only = true;
+        Stats stats{{"Shortened Conflicts", 0}};
+        REQUIRE(run(WINDOWS, config, &stats) == run(WINDOWS));
+        REQUIRE(stats["Shortened Conflicts"] > 0);
+    }
+    SECTION("check-only") {
+        Config config;
+        config.check_only = true;
+        REQUIRE(run("{x; y; z}.\n"
+                    "&even { x:x; y:y }.\n"
+                    "&odd  { x:x; z:z }.\n", config) == S{{"x", "y"}, {"z"}});
+
+        REQUIRE(run("{ x(1..6) }.\n"
+                    "&odd { X: x(X), X <= Y } :- Y = 1..6.\n", config) == S{{"x(1)"}});
+
+        config.check_interval = 1;
+        REQUIRE(run("{x; y; c}.\n"
+                    "&odd { x:x; y:y } :- c.\n", config) == S{
+                        {}, {"c", "x"}, {"c", "y"}, {"x"}, {"x", "y"}, {"y"}});
+    }
+    SECTION("pivot-budget") {
+        Config config;
+        config.pivot_budget = 1;
+        config.eliminate = false;
+        config.equivalences = false;
+        REQUIRE(run(WINDOWS, config) == run(WINDOWS));
+
+        auto [n, stats] = run_windows(config);
+        REQUIRE(n == 8);
+        REQUIRE(stats.exhausted > 0);
+
+        config.check_only = true;
+        REQUIRE(run(WINDOWS, config) == run(WINDOWS));
+    }
+    SECTION("reason-length") {
+        // Note: Skipped reasons are derived again once the literal that
+        // would have been propagated is assigned.
+        std::pair<Clingo::ClauseType, char const *> types[] = {
+            {Clingo::ClauseType::Learnt, "Clauses/Learnt"},
+            {Clingo::ClauseType::Static, "Clauses/Static"},
+            {Clingo::ClauseType::Volatile, "Clauses/Volatile"},
+            {Clingo::ClauseType::VolatileStatic, "Clauses/Volatile Static"}};
+        for (auto [type, name] : types) {
+            Config config;
+            config.reason_length = 1;
+            config.clause_type = type;
+            Stats stats{{"Skipped Reasons", 0}, {name, 0}};
+            REQUIRE(run(WINDOWS, config, &stats) == run(WINDOWS));
+            REQUIRE(stats["Skipped Reasons"] > 0);
+            REQUIRE(stats[name] > 0);
+        }
+    }
+    SECTION("activity") {
+        // Note: In check-only mode, XOR conflicts are detected on total
+        // assignments. Thus, variables are bumped independently of the
+        // propagation order of clingo.
+        Config config;
+        config.activity = true;
+        config.check_only = true;
+        Stats stats{{"Activity Decisions", 0}};
+        REQUIRE(run(WINDOWS, config, &stats) == run(WINDOWS));
+        REQUIRE(stats["Activity Decisions"] > 0);
+
+        config.engine = Engine::GaussJordan;
+        stats["Activity Decisions"] = 0;
+        REQUIRE(run(WINDOWS, config, &stats) == run(WINDOWS));
+        REQUIRE(stats["Activity Decisions"] > 0);
+    }
+    SECTION("phase") {
+        Config config;
+        config.phase = true;
+        REQUIRE(run("{x; y; z}.\n"
+                    "&even { x:x; y:y }.\n"
+                    "&odd  { x:x; z:z }.\n", config) == S{{"x", "y"}, {"z"}});
+
+        Stats stats{{"Phase Hints", 0}};
+        REQUIRE(run(WINDOWS, config, &stats) == run(WINDOWS));
+        REQUIRE(stats["Phase Hints"] > 0);
+
+        config.engine = Engine::GaussJordan;
+        stats["Phase Hints"] = 0;
+        REQUIRE(run(WINDOWS, config, &stats) == run(WINDOWS));
+        REQUIRE(stats["Phase Hints"] > 0);
     }
     SECTION("multi-shot") {
         REQUIRE(run_m({"{x; y; z}.\n"
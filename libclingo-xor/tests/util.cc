@@ -45,5 +45,140 @@ TEST_CASE("util") {
         // traverse the first column
         t.update_col(0, [](index_t j) { });
         REQUIRE(t.size() == 1);
+
+        // remove the third column
+        t.set(1, 1, true);
+        t.set(1, 2, true);
+        std::vector<index_t> rows;
+        t.remove_col(2, [&](index_t i) { rows.emplace_back(i); });
+        REQUIRE(rows == std::vector<index_t>{0, 1});
+        REQUIRE(t.size() == 1);
+        REQUIRE(t.contains(1, 1));
+
+        // remove the second row
+        t.remove_row(1);
+        REQUIRE(t.empty());
+    }
+    SECTION("dense-tableau") {
+        DenseTableau<2> t;
+        REQUIRE(t.empty());
+        REQUIRE(!t.contains(0, 0));
+
+        // set values in both words of a row
+        t.set(0, 2, true);
+        t.set(0, 70, true);
+        t.set(0, 70, true);
+        REQUIRE(t.size() == 2);
+        REQUIRE(t.contains(0, 70));
+
+        // traverse the first row in order
+        std::vector<index_t> cols;
+        t.update_row(0, [&](index_t j) {
+            cols.emplace_back(j);
+            return true;
+        });
+        REQUIRE(cols == std::vector<index_t>{2, 70});
+
+        // eliminate column 70 keeping the element in the updated row
+        t.set(1, 1, true);
+        t.set(1, 70, true);
+        std::vector<index_t> rows;
+        t.eliminate(0, 70, [&](index_t i) { rows.emplace_back(i); });
+        REQUIRE(rows == std::vector<index_t>{1});
+        REQUIRE(t.contains(1, 1));
+        REQUIRE(t.contains(1, 2));
+        REQUIRE(t.contains(1, 70));
+        REQUIRE(t.size() == 5);
+
+        // remove the third column
+        rows.clear();
+        t.remove_col(2, [&](index_t i) { rows.emplace_back(i); });
+        REQUIRE(rows == std::vector<index_t>{0, 1});
+        REQUIRE(t.size() == 3);
+
+        // remove the rows
+        t.remove_row(0);
+        t.remove_row(1);
+        REQUIRE(t.empty());
+    }
+    SECTION("activity-heap") {
+        ActivityHeap h;
+        h.resize(4);
+        REQUIRE(h.empty());
+        REQUIRE(h.activity(0) == 0);
+        for (index_t i = 0; i != 4; ++i) {
+            h.push(i);
+        }
+        REQUIRE(h.contains(3));
+
+        // later bumps weigh more than earlier ones
+        h.bump(2);
+        h.decay();
+        h.bump(1);
+        REQUIRE(h.top() == 1);
+        REQUIRE(h.activity(1) > h.activity(2));
+        h.pop();
+        REQUIRE(!h.contains(1));
+        REQUIRE(h.top() == 2);
+
+        // removed indices keep their activity
+        h.bump(2);
+        h.push(1);
+        h.pop();
+        REQUIRE(h.top() == 1);
+    }
+    SECTION("bitset") {
+        BitSet b;
+        b.resize(130);
+        REQUIRE(b.size() == 130);
+        REQUIRE(!b.test(0));
+        REQUIRE(!b.test(129));
+
+        b.set(0);
+        b.set(64);
+        b.flip(129);
+        REQUIRE(b.test(0));
+        REQUIRE(!b.test(1));
+        REQUIRE(b.test(64));
+        REQUIRE(b.test(129));
+
+        b.reset(64);
+        b.assign(1, true);
+        b.flip(129);
+        REQUIRE(b.test(1));
+        REQUIRE(!b.test(64));
+        REQUIRE(!b.test(129));
+
+        // new bits are cleared
+        b.resize(200);
+        REQUIRE(b.test(0));
+        REQUIRE(!b.test(199));
+
+        // swap bits
+        b.swap(0, 199);
+        REQUIRE(!b.test(0));
+        REQUIRE(b.test(199));
+
+        // find bits word by word
+        auto find = [&](size_t begin, size_t end) {
+            return BitSet::find_first(begin, end, [&](size_t k) { return b.word(k); });
+        };
+        REQUIRE(find(0, 200) == 1);
+        REQUIRE(find(2, 200) == 199);
+        REQUIRE(find(2, 199) == 199);
+        REQUIRE(find(70, 150) == 150);
+    }
+    SECTION("parallel_for") {
+        std::vector<size_t> res(1000, 0);
+        parallel_for(res.size(), 4, [&](size_t i) { res[i] += i; });
+        for (size_t i = 0; i < res.size(); ++i) {
+            REQUIRE(res[i] == i);
+        }
+
+        REQUIRE_THROWS_AS(parallel_for(res.size(), 4, [&](size_t i) {
+            if (i == 500) {
+                throw std::runtime_error("error");
+            }
+        }), std::runtime_error);
     }
 };